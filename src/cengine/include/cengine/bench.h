@@ -0,0 +1,82 @@
+#pragma once
+
+#include "engine.h"
+
+// Benchmarking namespace for the search
+namespace bench
+{
+    // Built-in benchmark positions
+    extern const std::vector<std::string> positions;
+    extern const std::vector<std::string> bench_positions;
+
+    /*
+
+    ### Bench
+
+    Fixed depth search on the `bench_positions`, reports the total nodes, speed
+    and the node signature. The signature changes only if the search changes
+    functionally (with a single thread), so it separates pure speed changes from
+    the ones that alter the search
+    
+    */
+    class Bench
+    {
+    public:
+        static constexpr int DEFAULT_DEPTH = 6;
+
+        struct Result
+        {
+            uint64_t nodes     = 0;
+            uint64_t time      = 0;
+            uint64_t signature = 0;
+        };
+
+        Bench(bool print = true);
+
+        Result run(int depth = DEFAULT_DEPTH, size_t hash = chess::SearchCache::DEFAULT_HASH_SIZE, size_t threads = 1);
+
+        /**
+         * @brief Set if the benchmark should print the results
+         */
+        void setPrint(bool print) { m_print = print; }
+
+    private:
+        bool m_print;
+    };
+
+    /*
+    
+    ### Time to depth
+
+    Lazy SMP benchmark, runs a fixed depth search on the benchmark positions
+    with 1, 2, 4 ... `max_threads` threads and reports the time needed
+    to reach the depth (and the speedup compared to the single thread run)
+    
+    */
+    class TimeToDepth
+    {
+    public:
+        // Result of the benchmark, for given number of threads
+        struct Entry
+        {
+            size_t threads = 1;
+            uint64_t time  = 0;
+            uint64_t nodes = 0;
+            chess::SearchStats stats = {};
+        };
+
+        TimeToDepth(bool print = true);
+
+        std::vector<Entry> run(int depth = 10, size_t max_threads = 1, size_t hash = chess::SearchCache::DEFAULT_HASH_SIZE);
+
+        /**
+         * @brief Set if the benchmark should print the results
+         */
+        void setPrint(bool print) { m_print = print; }
+    
+    private:
+        Entry M_run_threads(int depth, size_t threads, size_t hash);
+
+        bool m_print;
+    };
+}
@@ -16,6 +16,7 @@
 #include "zobrist.h"
 #include "mailbox.h"
 #include "magic_bitboards.h"
+#include "nnue.h"
 
 namespace chess
 {
@@ -36,6 +37,142 @@ namespace chess
         UNKNOWN
     };
 
+    // Type of the moves to generate, captures include the capture promotions,
+    // quiets include the quiet promotions and castling, evasions are the moves
+    // that may resolve a check (pseudo-legal generation only)
+    enum GenType
+    {
+        ALL_MOVES = 0,
+        CAPTURES,
+        QUIETS,
+        EVASIONS
+    };
+
+    /**
+     * @brief Generate the in_between array, gives the squares in-between two squares
+     * (exclusive) if they are on the same line, 0 otherwise.
+     * Taken from: https://www.chessprogramming.org/Square_Attacked_By
+     * For example, in_between[0][8] gives the squares in-between f6 and c3:
+     * . . . . . . . . 8
+     * . . . . . . . . 7
+     * . . . . . . . . 6
+     * . . . . 1 . . . 5
+     * . . . 1 . . . . 4
+     * . . . . . . . . 3
+     * . . . . . . . . 2
+     * . . . . . . . . 1
+     * a b c d e f g h
+     */
+    constexpr Table<Bitboard, 64, 64> init_in_between()
+    {
+        const uint64_t m1   = (-1);
+        const uint64_t a2a7 = (0x0001010101010100);
+        const uint64_t b2g7 = (0x0040201008040200);
+        const uint64_t h1b7 = (0x0002040810204080); /* Thanks Dustin, g2b7 did not work for c1-a3 */
+
+        Table<Bitboard, 64, 64> in_between = {};
+        for(int i = 0; i < 64; i++){
+            for(int j = 0; j < 64; j++){
+                uint64_t btwn, line, rank, file;
+                btwn  = (m1 << i) ^ (m1 << j);
+                file  =   (j & 7) - (i   & 7);
+                rank  =  ((j | 7) -  i) >> 3 ;
+                line  =      (   (file  &  7) - 1) & a2a7; /* a2a7 if same file */
+                line += 2 * ((   (rank  &  7) - 1) >> 58); /* b1g1 if same rank */
+                line += (((rank - file) & 15) - 1) & b2g7; /* b2g7 if same diagonal */
+                line += (((rank + file) & 15) - 1) & h1b7; /* h1b7 if same antidiag */
+                line *= btwn & -btwn; /* mul acts like shift by smaller square */
+                in_between[i][j] = line & btwn;   /* return the bits on that line in-between */
+            }
+        }
+        return in_between;
+    }
+
+    /**
+     * @brief Generate the pawn attacks, [is_white][square]
+     */
+    constexpr Table<Bitboard, 2, 64> init_pawn_attacks()
+    {
+        Table<Bitboard, 2, 64> attacks = {};
+        for(int i = 0; i < 64; i++){
+            for(int j = 0; j < 2; j++){
+                for(int k = 0; k < 2; k++){
+                    int n = Mailbox::mailbox[Mailbox::mailbox64[i] + Mailbox::pawn_attack_offsets[j][k]];
+                    if(n != -1){
+                        attacks[j][i] |= 1ULL << n;
+                    }
+                }
+            }
+        }
+        return attacks;
+    }
+
+    /**
+     * @brief Generate the piece attacks on an empty board, [type - 1][square]
+     * (pawn attacks are in `init_pawn_attacks`)
+     */
+    constexpr Table<Bitboard, 6, 64> init_piece_attacks()
+    {
+        Table<Bitboard, 6, 64> attacks = {};
+        for(int i = 0; i < 64; i++)
+        {
+            attacks[Piece::King - 1][i]   = Mailbox::mailboxAttacks(Piece::King - 1, 0, i , false);
+            attacks[Piece::Knight - 1][i] = Mailbox::mailboxAttacks(Piece::Knight - 1, 0, i , false);
+            attacks[Piece::Bishop - 1][i] = Mailbox::mailboxAttacks(Piece::Bishop - 1, 0, i, true);
+            attacks[Piece::Rook - 1][i]   = Mailbox::mailboxAttacks(Piece::Rook - 1, 0, i, true);
+            attacks[Piece::Queen - 1][i]  = Mailbox::mailboxAttacks(Piece::Queen - 1, 0, i, true);
+        }
+        return attacks;
+    }
+
+    // Cuckoo hash table of the reversible moves, for the upcoming repetition detection,
+    // see `init_cuckoo` and `Board::hasUpcomingRepetition`
+    struct Cuckoo
+    {
+        static constexpr int SIZE = 8192;
+
+        Table<Hash, SIZE>     keys;  // piece key on 'from' ^ on 'to' ^ side key
+        Table<uint16_t, SIZE> moves; // from | to << 6
+
+        static constexpr int h1(Hash key) { return int(key & (SIZE - 1)); }
+        static constexpr int h2(Hash key) { return int((key >> 16) & (SIZE - 1)); }
+    };
+
+    /**
+     * @brief Generate the cuckoo tables, each reversible move of a non-pawn piece
+     * (on an empty board) is stored under one of its two hash slots.
+     * Based on: https://web.archive.org/web/20201107002606/https://marcelk.net/2013-04-06/paper/upcoming-rep-v2.pdf
+     */
+    constexpr Cuckoo init_cuckoo()
+    {
+        constexpr Table<Bitboard, 6, 64> attacks = init_piece_attacks();
+        Cuckoo cuckoo = {};
+
+        for (int color = 0; color < 2; color++)
+            for (int type = Piece::Knight - 1; type < 6; type++)
+                for (int from = 0; from < 64; from++)
+                    for (int to = from + 1; to < 64; to++)
+                    {
+                        if (!(attacks[type][from] & (1ULL << to)))
+                            continue;
+
+                        Hash key  = zobrist_keys.pieces[color][type][from]
+                            ^ zobrist_keys.pieces[color][type][to] ^ zobrist_keys.turn;
+                        uint16_t move = uint16_t(from | to << 6);
+
+                        // Insert the move, kicking out the previous occupant to its other slot
+                        for (int i = Cuckoo::h1(key);;)
+                        {
+                            std::swap(cuckoo.keys[i], key);
+                            std::swap(cuckoo.moves[i], move);
+                            if (!key)
+                                break;
+                            i = (i == Cuckoo::h1(key)) ? Cuckoo::h2(key) : Cuckoo::h1(key);
+                        }
+                    }
+        return cuckoo;
+    }
+
     /**
      * ## Board
      * 
@@ -43,22 +180,26 @@ namespace chess
      * Uses both mailbox and bitboard representation.
      * 
      */
-    class Board: public Mailbox
+    class Board: public Mailbox, public Position
     {
         friend class Engine;
         friend class Thread;
         friend class Eval;
         friend class Extensions;
+        friend class NNUE;
 
         inline void restore_state(State& state);
+        inline void add_piece_acc(bool is_white, int type, Square sq);
+        inline void remove_piece_acc(bool is_white, int type, Square sq);
         inline void undo(Square from, Square to, bool is_white, int type);
         void push_state(Move move);
+        inline void push_nnue_acc();
+        inline void pop_nnue_acc();
         void verify_castling_rights();
-        static void init_board();
 
         typedef Bitboard(*attacks_func_t)(Bitboard, int);
 
-        template<int PieceType>
+        template<GenType gen, int PieceType>
         void _gen_sliding_moves_no_check(
             chess::MoveList* moves, Bitboard piece_bb,
             Bitboard occupied, Bitboard enemy_pieces, 
@@ -66,7 +207,7 @@ namespace chess
             attacks_func_t attackFunc
         );
 
-        template<int PieceType>
+        template<GenType gen, int PieceType>
         void _gen_pieces_moves_in_check(
             chess::MoveList* moves, Bitboard piece_bb,
             Bitboard occupied, Bitboard attackers, 
@@ -74,15 +215,34 @@ namespace chess
             int attackers_sq, attacks_func_t attackFunc
         );
 
+        template<int PieceType>
+        void _gen_piece_moves(MoveList& moves, Bitboard pieces, Bitboard occupied, Bitboard enemy, Bitboard targets);
+
+        template<int Us, GenType gen>
+        Bitboard _gen_pawn_moves(MoveList& moves, Bitboard pawns, Bitboard occupied, Bitboard push_targets, Bitboard capture_targets);
+
+        template<int Us, GenType gen>
+        void _gen_pseudo_legal(MoveList& moves);
+
+        template<int Us, GenType gen>
+        MoveList _gen_legal();
+
+        template<int Us, GenType gen>
+        MoveList _gen_evasions(Bitboard danger);
+
+        template<int Us>
+        Bitboard _gen_danger();
+
         bool _read_base_fen(std::istringstream& fen);
 
     public:
         typedef MoveList::move_filter_t MoveFilter;
 
-        // Helper bitboards initialized by `init_board()`
-        static Bitboard in_between[64][64];
-        static Bitboard pawnAttacks[2][64];
-        static Bitboard pieceAttacks[6][64];
+        // Helper bitboards, generated at compile time
+        static constexpr Table<Bitboard, 64, 64> in_between  = init_in_between();
+        static constexpr Table<Bitboard, 2, 64>  pawnAttacks  = init_pawn_attacks();
+        static constexpr Table<Bitboard, 6, 64>  pieceAttacks = init_piece_attacks();
+        static constexpr Cuckoo                  cuckoo       = init_cuckoo();
 
         // Starting position
         static const char START_FEN[57];
@@ -110,8 +270,13 @@ namespace chess
         void undoNullMove();
         void makeMove(Move move);
         void undoMove(Move move);
+        void restore(const Position& position);
+        void reserve(size_t plies);
         Hash hash();
         Hash pawnHash();
+        Hash keyAfter(Move move) const;
+        Hash pawnKeyAfter(Move move) const;
+        const Accumulator& refreshAccumulator();
 
         /**
          * @brief Get the termination of the game, it doesn't calculate it
@@ -123,6 +288,22 @@ namespace chess
          */
         Hash getHash() const {return this->m_hash; };
 
+        /**
+         * @brief Get the hash of the pawn structure, doesn't calculate it
+         */
+        Hash getPawnHash() const {return this->m_pawn_hash; };
+
+        /**
+         * @brief Get the position part of the board, save it before making a move
+         * to undo it with `restore`
+         */
+        const Position& position() const {return *this; };
+
+        /**
+         * @brief Get the evaluation accumulator, doesn't calculate it
+         */
+        const Accumulator& accumulator() const {return this->m_acc; };
+
 
         // Termination checks
         void setTermination(Termination t = Termination::RESIGNATION) {
@@ -133,6 +314,8 @@ namespace chess
         bool isTerminated(MoveList* ml);
         template <RepetitionType type = Threefold>
         bool isRepetition();
+        bool isRepetition(int ply) const;
+        bool hasUpcomingRepetition(int ply) const;
         bool isInsufficientMaterial();
         bool isDraw();
         bool isCheckmate(MoveList* ml);
@@ -140,12 +323,22 @@ namespace chess
 
 
         bool isLegal(Move move);
+        bool isValid(Move move);
+        bool isLegalAfter(Move move);
+        void updateChecks();
         Move match(Move move);
 
+        Bitboard attackersTo(Square sq, Bitboard occupied);
+        Bitboard checkers();
         Bitboard generateDanger();
-        inline MoveList generateEvasions(Bitboard danger);
+        template <GenType gen = ALL_MOVES>
+        MoveList generateEvasions(Bitboard danger);
         MoveList generateLegalCaptures();
+        MoveList generateLegalQuiets();
+        template <GenType gen = ALL_MOVES>
         MoveList generateLegalMoves();
+        template <GenType gen = ALL_MOVES>
+        MoveList generatePseudoLegalMoves();
         MoveList filterMoves(MoveFilter filter);
 
         void print();
@@ -205,7 +398,7 @@ namespace chess
         /**
          * @brief Get raw board data
          */
-        inline int* getBoard() {return this->board; }
+        inline int8_t* getBoard() {return this->board; }
 
         /**
          * @brief Get the history of the game
@@ -280,6 +473,18 @@ namespace chess
             return m_bitboards[side][PAWN_TYPE];
         }
 
+        /**
+         * @brief Get the squares attacked by the pawns of given side, set-wise (no lookups)
+         */
+        inline Bitboard pawnAttacksBy(bool side) const
+        {
+            constexpr Bitboard not_file_a = ~0x0101010101010101ULL;
+            constexpr Bitboard not_file_h = ~0x8080808080808080ULL;
+            const Bitboard pawns = m_bitboards[side][PAWN_TYPE];
+            return side ? ((pawns & not_file_a) >> 9) | ((pawns & not_file_h) >> 7)
+                        : ((pawns & not_file_a) << 7) | ((pawns & not_file_h) << 9);
+        }
+
         /**
          * @brief Get the queens bitboard
          */
@@ -318,25 +523,16 @@ namespace chess
         /**
          * @brief Get the piece at a given index
          */
-        inline int& operator[](int index) {return this->board[index]; };
+        inline int8_t& operator[](int index) {return this->board[index]; };
         inline int operator[](int index) const {return this->board[index]; };
         
         
-        Hash m_hash;
-        int board[64];
-        bool m_in_check;
-        int m_side;
-        int m_enpassant_target;
-        int m_halfmove_clock;
-        int m_fullmove_counter;
-        int m_captured_piece;
-        int m_irreversible_index; // last irreversible move index
-        Bitboard m_bitboards[2][6]; // 0: white, 1: black, contains bitboards for each piece type
         Bitboard m_danger; // All attacked squares by the enemy
         Bitboard m_activity[6]; // Activity table for each piece (only for this side)
         Bitboard m_enemy_activity[6];
-        CastlingRights m_castling_rights;
         StateList m_history;
+        std::vector<Hash> m_keys; // hashes of the history positions, contiguous for the repetition checks
+        std::vector<NNUE::Accumulator> m_nnue; // network accumulators, one per history entry (if active)
         Termination m_termination;
     };
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstring>
+#include <memory>
 
 #include "types.h"
 #include "transp_table.h"
@@ -17,6 +18,14 @@ namespace chess
         uint64_t activity;
     };
 
+    // Cached pawn structure evaluation, from white's perspective
+    struct PawnEntry : public BaseTTEntry
+    {
+        int eval;
+    };
+
+    typedef TTable<PawnEntry> PawnTable;
+
     class HistoryHeuristic
     {
     public:
@@ -68,8 +77,6 @@ namespace chess
         // - the move caused a beta-cutoff
         inline void update(Move killer, Depth ply)
         {
-            static int killer_index = 0;
-            
             // If empty or already in the list of killers, then exit
             for(int i = 0; i < MOVES_PER_PLY; ++i)
                 if (moves[ply][i] == killer)
@@ -90,6 +97,12 @@ namespace chess
             return false;
         }
 
+        // Get the `i`-th killer move at given ply
+        inline Move get(Depth ply, int i) const
+        {
+            return moves[ply][i];
+        }
+
         /**
          * @brief Clear the killer moves
          */
@@ -102,19 +115,36 @@ namespace chess
 
     private:
         std::vector<std::vector<Move>> moves;
+        int killer_index = 0;
     };
 
 
     /**
-     * @brief Cache for search information
+     * @brief Cache for search information, each search thread owns its 
+     * history and killer heuristics and pawn table, the transposition table may be shared
      */
     class SearchCache
     {
     public:
         // Default hash size, in MB
         static constexpr size_t DEFAULT_HASH_SIZE = 16;
+        // Default pawn hash size, in MB
+        static constexpr size_t DEFAULT_PAWN_HASH_SIZE = 1;
+
+        SearchCache(size_t pawn_hash_size = DEFAULT_PAWN_HASH_SIZE): 
+            pt(pawn_hash_size), pt_size(pawn_hash_size), tt(std::make_shared<TranspositionTable>(DEFAULT_HASH_SIZE)) {}
+
+        /**
+         * @brief Create a cache using the transposition table of `shared` (Lazy SMP helpers),
+         * no table of its own is allocated
+         */
+        SearchCache(const SearchCache& shared, size_t pawn_hash_size): 
+            pt(pawn_hash_size), pt_size(pawn_hash_size), tt(shared.tt) {}
 
-        SearchCache(): tt(DEFAULT_HASH_SIZE) {}
+        /**
+         * @brief Use the transposition table of `other`, heuristics are not shared
+         */
+        inline void shareTT(const SearchCache& other) { tt = other.tt; }
         
         /**
          * @brief Get the history heuristic object
@@ -124,17 +154,37 @@ namespace chess
         /**
          * @brief Get the transposition table object
          */
-        inline TTable<TEntry>& getTT() { return tt; }
+        inline TranspositionTable& getTT() { return *tt; }
 
         /**
          * @brief Get the killer table
          */
         inline KillerHeuristic& getKH() { return kh; }
 
+        /**
+         * @brief Get the pawn structure table (owned by the thread)
+         */
+        inline PawnTable& getPT() { return pt; }
+
+        /**
+         * @brief Reallocate the pawn table, if the size changed
+         * @param sizeMB new size in MB
+         */
+        inline void resizePawnTable(size_t sizeMB)
+        {
+            if (sizeMB == pt_size)
+                return;
+
+            pt      = PawnTable(sizeMB);
+            pt_size = sizeMB;
+        }
+
     private:
         KillerHeuristic kh;
         HistoryHeuristic hh;
-        TTable<TEntry> tt;
+        PawnTable pt;
+        size_t pt_size;
+        std::shared_ptr<TranspositionTable> tt;
     };
 
     // Used for 'improving'
@@ -25,6 +25,7 @@
 
 #include "settings.h"
 #include "perft.h"
+#include "bench.h"
 #include "move.h"
 #include "uci.h"
 #include "magic_bitboards.h"
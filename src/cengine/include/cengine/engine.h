@@ -29,17 +29,30 @@ namespace chess
         static void base_init();
         void reset();
         uint64_t perft(int depth, bool print = true);
+        bool perftSuite(int depth, bool print = true);
         shared_data<Result>& go(const SearchOptions& options);
         void join();
         void stop();
+        void ponderhit();
         bool setPosition(const std::string& fen = Board::START_FEN);
         bool setPosition(std::istringstream& fen);
         void setPosition(const Board& board);
+        SearchStats stats() const;
 
         // uci options
 
         void setHashSize(size_t hash);
+        void setPawnHashSize(size_t hash);
+        void setThreads(size_t threads);
+        void setMultiPV(size_t lines);
         void setLogFile(const std::string& file);
+        void setEvalFile(const std::string& file);
+        void setUseNNUE(bool use);
+
+        /**
+         * @brief Get the number of search threads (main thread included)
+         */
+        size_t threads() const { return m_helpers.size() + 1; }
 
         /**
          * @brief Get the board
@@ -49,5 +62,18 @@ namespace chess
         Thread m_main_thread;
         Board m_board;
         SearchCache m_search_cache;
+
+        // Lazy SMP helper threads, each with its own heuristics
+        std::vector<std::unique_ptr<Thread>> m_helpers;
+        std::vector<SearchCache> m_helper_caches;
+
+        // Pawn table size (in MB) of each search thread
+        size_t m_pawn_hash_size = SearchCache::DEFAULT_PAWN_HASH_SIZE;
+
+        // Number of lines to search (MultiPV)
+        size_t m_multipv = 1;
+
+        // Last requested NNUE network file
+        std::string m_eval_file;
     };
 }
\ No newline at end of file
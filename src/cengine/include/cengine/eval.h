@@ -6,6 +6,285 @@
 
 namespace chess
 {
+    // Source: https://www.chessprogramming.org/Simplified_Evaluation_Function
+    // Added [0] -> middle game, [1] -> endgame tables, [6] -> type of a piece
+    constexpr int white_piece_square_table[2][6][64] = {
+        {
+            // pawn
+            {0,  0,  0,  0,  0,  0,  0,  0,
+            50, 50, 50, 50, 50, 50, 50, 50,
+            10, 10, 20, 30, 30, 20, 10, 10,
+            5,  5, 10, 25, 25, 10,  5,  5,
+            0,  0,  0, 20, 20,  0,  0,  0,
+            5, -5,-10,  0,  0,-10, -5,  5,
+            5, 10, 10,-20,-20, 10, 10,  5,
+            0,  0,  0,  0,  0,  0,  0,  0,},
+            // knight
+            {-50,-40,-30,-30,-30,-30,-40,-50,
+            -40,-20,  0,  0,  0,  0,-20,-40,
+            -30,  0, 10, 15, 15, 10,  0,-30,
+            -30,  5, 15, 20, 20, 15,  5,-30,
+            -30,  0, 15, 20, 20, 15,  0,-30,
+            -30,  5, 10, 15, 15, 10,  5,-30,
+            -40,-20,  0,  5,  5,  0,-20,-40,
+            -50,-40,-30,-30,-30,-30,-40,-50,},
+            // king
+            {-30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -20,-30,-30,-40,-40,-30,-30,-20,
+            -10,-20,-20,-20,-20,-20,-20,-10,
+            20, 20,  0,  0,  0,  0, 20, 20,
+            20, 30, 20,  0,  0, 10, 30, 20},
+            // bishop
+            {-20,-10,-10,-10,-10,-10,-10,-20,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -10,  0,  5, 10, 10,  5,  0,-10,
+            -10,  5,  5, 10, 10,  5,  5,-10,
+            -10,  0, 10, 10, 10, 10,  0,-10,
+            -10, 10, 10, 10, 10, 10, 10,-10,
+            -10,  5,  0,  0,  0,  0,  5,-10,
+            -20,-10,-10,-10,-10,-10,-10,-20,},
+            // rook
+            {0,  0,  0,  0,  0,  0,  0,  0,
+            5, 10, 10, 10, 10, 10, 10,  5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            0,  0,  0,  5,  5,  0,  0,  0},
+            // queen
+            {-20,-10,-10, -5, -5,-10,-10,-20,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -10,  0,  5,  5,  5,  5,  0,-10,
+            -5,  0,  5,  5,  5,  5,  0, -5,
+            0,  0,  5,  5,  5,  5,  0, -5,
+            -10,  5,  5,  5,  5,  5,  0,-10,
+            -10,  0,  5,  0,  0,  0,  0,-10,
+            -20,-10,-10, -5, -5,-10,-10,-20},
+        },
+
+        // endgame
+        {
+            //pawn
+            {0,  0,  0,  0,  0,  0,  0,  0,
+            50, 50, 50, 50, 50, 50, 50, 50,
+            10, 10, 20, 30, 30, 20, 10, 10,
+            5,  5, 10, 25, 25, 10,  5,  5,
+            0,  0,  0, 20, 20,  0,  0,  0,
+            5, -5,-10,  0,  0,-10, -5,  5,
+            5, 10, 10,-20,-20, 10, 10,  5,
+            0,  0,  0,  0,  0,  0,  0,  0,},
+
+            // knight
+            {-50,-40,-30,-30,-30,-30,-40,-50,
+            -40,-20,  0,  0,  0,  0,-20,-40,
+            -30,  0, 10, 15, 15, 10,  0,-30,
+            -30,  5, 15, 20, 20, 15,  5,-30,
+            -30,  0, 15, 20, 20, 15,  0,-30,
+            -30,  5, 10, 15, 15, 10,  5,-30,
+            -40,-20,  0,  5,  5,  0,-20,-40,
+            -50,-40,-30,-30,-30,-30,-40,-50},
+
+            // king
+            {-50,-40,-30,-20,-20,-30,-40,-50,
+            -30,-20,-10,  0,  0,-10,-20,-30,
+            -30,-10, 20, 30, 30, 20,-10,-30,
+            -30,-10, 30, 40, 40, 30,-10,-30,
+            -30,-10, 30, 40, 40, 30,-10,-30,
+            -30,-10, 20, 30, 30, 20,-10,-30,
+            -30,-30,  0,  0,  0,  0,-30,-30,
+            -50,-30,-30,-30,-30,-30,-30,-50},
+
+            // bishop
+            {-20,-10,-10,-10,-10,-10,-10,-20,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -10,  0,  5, 10, 10,  5,  0,-10,
+            -10,  5,  5, 10, 10,  5,  5,-10,
+            -10,  0, 10, 10, 10, 10,  0,-10,
+            -10, 10, 10, 10, 10, 10, 10,-10,
+            -10,  5,  0,  0,  0,  0,  5,-10,
+            -20,-10,-10,-10,-10,-10,-10,-20},
+
+            // rook
+            {0,  0,  0,  0,  0,  0,  0,  0,
+            5, 10, 10, 10, 10, 10, 10,  5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            0,  0,  0,  5,  5,  0,  0,  0},
+
+            // queen
+            {-20,-10,-10, -5, -5,-10,-10,-20,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -10,  0,  5,  5,  5,  5,  0,-10,
+             -5,  0,  5,  5,  5,  5,  0, -5,
+              0,  0,  5,  5,  5,  5,  0, -5,
+            -10,  5,  5,  5,  5,  5,  0,-10,
+            -10,  0,  5,  0,  0,  0,  0,-10,
+            -20,-10,-10, -5, -5,-10,-10,-20},
+        }
+    };
+
+    // [type][sq], for white, black ones are mirrored
+    constexpr Byte white_mobility_weights[6][64] = {
+        {
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+        }, // pawn
+        {
+            // knight
+            0,  4,  4,  2,  2,  2,  4,  0,
+            2,  3,  3,  4,  4,  3,  3,  2,
+            1,  4,  4,  4,  4,  4,  3,  1,
+            1,  3,  4,  5,  5,  4,  3,  1,
+            0,  1,  3,  4,  4,  3,  1,  0,
+            0,  1,  1,  1,  1,  1,  1,  0,
+           -1,  0,  0, -1, -1,  0,  0, -1,
+           -4, -2, -2, -2, -2, -2, -2, -4,
+        },
+        {
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 1, 1, 1, 1, 1, 1, 1,
+        }, // king
+        {
+            // bishop 
+            2,  4,  2,  2,  2,  2,  4,  2,
+            3,  4,  3,  4,  4,  3,  4,  3,
+            1,  2,  4,  4,  4,  4,  2,  1,
+            1,  3,  4,  5,  5,  4,  3,  1,
+            0,  2,  3,  5,  5,  3,  2,  0,
+            0,  1,  1,  2,  2,  1,  1,  0,
+           -1,  0,  0, -1, -1,  0,  0, -1,
+           -4, -2, -2, -2, -2, -2, -2, -4,
+        },
+        {
+            // rook (max 44)
+            0,  5,  5,  5,  5,  5,  5,  0,
+            2,  3,  3,  5,  5,  3,  3,  2,
+            1,  2,  3,  4,  4,  3,  2,  1,
+            1,  3,  4,  5,  5,  4,  3,  1,
+            0,  2,  2,  4,  4,  2,  2,  0,
+            0,  1,  2,  2,  2,  2,  1,  0,
+           -1,  0,  0,  0,  0,  0,  0, -1,
+           -1, -1, -1, -1, -1, -1, -1, -1,
+        },
+        {
+            // queen
+            2,  4,  2,  2,  2,  2,  4,  2,
+            3,  4,  3,  4,  4,  3,  4,  3,
+            1,  2,  4,  4,  4,  4,  2,  1,
+            1,  3,  4,  5,  5,  4,  3,  1,
+            0,  2,  3,  5,  5,  3,  2,  0,
+            0,  1,  1,  2,  2,  1,  1,  0,
+           -1,  0,  0, -1, -1,  0,  0, -1,
+           -4, -2, -2, -2, -2, -2, -2, -4,
+        }
+    };
+
+    // [turn][type][sq]
+    constexpr Table<Byte, 2, 6, 64> init_mobility_weights()
+    {
+        Table<Byte, 2, 6, 64> weights = {};
+        for (int type = 0; type < 6; type++){
+            for (int j = 0; j < 64; j++){
+                weights[1][type][j] = white_mobility_weights[type][j];
+                weights[0][type][j] = white_mobility_weights[type][63 - j];
+            }
+        }
+        return weights;
+    }
+
+    // evaluate piece based on it's position, [turn][state][type][square]
+    constexpr Table<int, 2, 2, 6, 64> init_piece_square_table()
+    {
+        Table<int, 2, 2, 6, 64> table = {};
+        for (int state = 0; state < 2; state++){
+            for (int type = 0; type < 6; type++){
+                for (int j = 0; j < 64; j++){
+                    table[1][state][type][j] = white_piece_square_table[state][type][j];
+                    table[0][state][type][j] = white_piece_square_table[state][type][63 - j];
+                }
+            }
+        }
+        return table;
+    }
+
+    // Passed pawn masks, [side][square], the squares in front of the pawn (and on the adjacent files)
+    constexpr Table<Bitboard, 2, 64> init_passed_pawn_masks()
+    {
+        Table<Bitboard, 2, 64> masks = {};
+        for(int side = 0; side < 2; side++)
+        {
+            for(Square sq = 0; sq < 64; sq++)
+            {
+                int rank = sq >> 3;
+                int file = sq % 8;
+                Bitboard file_bb = 0;
+
+                // Iterate through this square and it's sides
+                for (int i = -1; i < 2; i++)
+                {
+                    // File out of board bounds
+                    if (file + i < 0 || file + i > 7)
+                        continue;
+
+                    // Get file bitboard for this square
+                    file_bb |= 0x0101010101010101ULL << (file + i);
+
+                    // Delete all bits BELOW or equal to this rank
+                    if (side == 0)
+                        for (int r = 0; r <= rank && rank < 7; r++)
+                            file_bb &= ~(1ULL << (8*r + file + i));
+                    // Delete all bits ABOVE or eqaul to this rank
+                    else 
+                        for (int r = rank; r < 8 && rank > 0; r++)
+                            file_bb &= ~(1ULL << (8*r + file + i));
+                }
+
+                masks[side][sq] = file_bb;
+            }
+        }
+        return masks;
+    }
+
+    // manhattan distance [from|to][to|from] (symetrical)
+    constexpr Table<int8_t, 64, 64> init_manhattan_distance()
+    {
+        Table<int8_t, 64, 64> distance = {};
+        for (int i = 0; i < 64; i++)
+        {
+            int rank = i / 8;
+            int file = i % 8;
+
+            for (int j = 0; j < 64; j++)
+            {
+                int rank2 = j / 8;
+                int file2 = j % 8;
+
+                distance[i][j] = int8_t((rank > rank2 ? rank - rank2 : rank2 - rank)
+                    + (file > file2 ? file - file2 : file2 - file));
+            }
+        }
+        return distance;
+    }
+
     // Evaluation class
     class Eval
     {
@@ -53,23 +332,17 @@ namespace chess
             int middlegame_factor;
         } material_factors_t;
 
-        typedef struct PawnEntry : public BaseTTEntry {
-            int eval;
-        } PawnEntry;
-
-        // Manhatten distance of a squara
-        static int8_t manhattan_distance[64][64];
-
-        static const int white_piece_square_table[2][6][64];
-        static Byte mobility_weights[2][6][64];
-        static int piece_square_table[2][2][6][64];
-        static Bitboard passed_pawn_masks[2][64];
-        static TTable<PawnEntry> pawn_table;
+        // Evaluation tables, generated at compile time (visible to the compiler in every
+        // translation unit, so the lookups with constant indices are folded)
+        static constexpr Table<int8_t, 64, 64>   manhattan_distance = init_manhattan_distance();
+        static constexpr Table<Byte, 2, 6, 64>   mobility_weights   = init_mobility_weights();
+        static constexpr Table<int, 2, 2, 6, 64> piece_square_table = init_piece_square_table();
+        static constexpr Table<Bitboard, 2, 64>  passed_pawn_masks  = init_passed_pawn_masks();
 
         Eval() = delete;
         
-        static void init();
-        static int evaluate(Board& board);
+        static int evaluate(Board& board, PawnTable* pawn_table = nullptr);
         static material_factors_t get_factors(Board& board);
+        static bool see(Board& board, Move move, int threshold = 0);
     };
 }
\ No newline at end of file
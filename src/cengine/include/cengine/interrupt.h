@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <algorithm>
 
 #include "search_options.h"
 
@@ -8,13 +9,29 @@ namespace chess
 {
 
 
-// Class to handle interrupts (`stop` signal, time limit, etc.)
+// Class to handle interrupts (`stop` signal, time limit, etc.), each search thread
+// owns one. The node counter is written only by the owner (other threads may read it),
+// the clock and the limits are checked every `interval` nodes, which adapts to the
+// measured speed, so that the clock is read about once per millisecond.
+// While pondering the time limits are not checked, until the `ponderhit`.
 class Interrupt
 {
+public:
+    typedef chess::TimeMan::Time Time;
+
+    // Bounds of the polling interval (in nodes)
+    static constexpr uint64_t MIN_INTERVAL = 256;
+    static constexpr uint64_t MAX_INTERVAL = 16384;
+
+private:
     std::atomic_bool m_ignore;
     std::atomic_bool m_state;
     std::atomic_bool m_stop;
+    std::atomic_bool m_ponder;
+    std::atomic_bool m_ponderhit;
     std::atomic<uint64_t> m_nodes;
+    uint64_t m_next_poll;
+    uint64_t m_interval;
     Limits m_limits;
     chess::TimeMan m_time;
 
@@ -25,42 +42,102 @@ class Interrupt
         return (!ignore && (state || stop || cond));
     }
 
-public:
+    // First node count exceeding the node limit
+    static constexpr uint64_t M_node_limit(const Limits& limits)
+    {
+        return limits.nodes == std::numeric_limits<uint64_t>::max() ? limits.nodes : limits.nodes + 1;
+    }
+
+    // Check the stop signal, the time and node limits, schedule the next poll
+    void M_poll(uint64_t nodes)
+    {
+        if (!pondering())
+            m_time.check();
+
+        // Aim at one poll per millisecond, but never step over the node limit
+        Time elapsed = m_time.elapsed();
+        m_interval   = std::clamp(nodes / std::max<Time>(elapsed, 1), MIN_INTERVAL, MAX_INTERVAL);
+        m_next_poll  = std::min(nodes + m_interval, M_node_limit(m_limits));
+
+        m_state.store(M_get_state(
+            m_ignore.load(std::memory_order_relaxed), m_stop.load(std::memory_order_relaxed),
+            m_state.load(std::memory_order_relaxed), m_time.get() || nodes > m_limits.nodes
+        ), std::memory_order_relaxed);
+    }
 
-    Interrupt() : 
+public:
+    Interrupt() :
         m_ignore(false), m_state(false),
-        m_stop(false), m_nodes(0),
+        m_stop(false), m_ponder(false), m_ponderhit(false), m_nodes(0),
+        m_next_poll(MIN_INTERVAL), m_interval(MIN_INTERVAL),
         m_limits(), m_time() {}
 
     Interrupt(const Limits& limits) :
         m_ignore(false), m_state(false),
-        m_stop(false), m_nodes(0), 
+        m_stop(false), m_ponder(limits.ponder), m_ponderhit(false), m_nodes(0),
+        m_next_poll(std::min(MIN_INTERVAL, M_node_limit(limits))), m_interval(MIN_INTERVAL),
         m_limits(limits), m_time(limits.time) {}
 
-    Interrupt(Interrupt&& other) 
+    Interrupt(Interrupt&& other)
     {
         *this = std::move(other);
     }
 
     Interrupt& operator=(Interrupt&& other)
     {
-        m_ignore = other.m_ignore.load();
-        m_stop   = other.m_stop.load();
-        m_limits = other.m_limits;
-        m_nodes  = other.m_nodes.load();
-        m_time   = other.m_time;
+        m_ignore    = other.m_ignore.load();
+        m_state     = other.m_state.load();
+        m_stop      = other.m_stop.load();
+        m_ponder    = other.m_ponder.load();
+        m_ponderhit = other.m_ponderhit.load();
+        m_limits    = other.m_limits;
+        m_nodes     = other.m_nodes.load();
+        m_next_poll = other.m_next_poll;
+        m_interval  = other.m_interval;
+        m_time      = other.m_time;
         return *this;
     }
 
-    // Set the stop signal
-    void stop() { m_stop = true; }
+    // Set the stop signal (may be called from any thread),
+    // the search sees it immediately unless it's ignoring the signals
+    void stop()
+    {
+        m_stop.store(true, std::memory_order_relaxed);
+        if (!m_ignore.load(std::memory_order_relaxed))
+            m_state.store(true, std::memory_order_relaxed);
+    }
+
+    // The opponent played the expected move (may be called from any thread),
+    // the search continues with the time limits
+    void ponderhit()
+    {
+        m_ponderhit.store(true, std::memory_order_relaxed);
+    }
+
+    // Check if the search runs on the opponent's time, applies the pending
+    // `ponderhit` (call only from the searching thread)
+    bool pondering()
+    {
+        if (m_ponder.load(std::memory_order_relaxed) && m_ponderhit.load(std::memory_order_relaxed))
+        {
+            m_ponder.store(false, std::memory_order_relaxed);
+            m_time.ponderhit();
+        }
+        return m_ponder.load(std::memory_order_relaxed);
+    }
+
+    // Check if the stop signal was given
+    bool stopped() const
+    {
+        return m_stop.load(std::memory_order_relaxed);
+    }
 
-    // Sets the ignore flag to true, will cause the search to run 
-    // as if with the infinite parameter, 
+    // Sets the ignore flag to true, will cause the search to run
+    // as if with the infinite parameter,
     // but it cannot be stopped with `stop` signal
     // To stop this, call `restore_state`
-    void set_ignore() { 
-        m_ignore = true; 
+    void set_ignore() {
+        m_ignore = true;
         m_state  = false;
     }
 
@@ -68,17 +145,19 @@ public:
     void restore_state(int depth)
     {
         m_ignore = false;
+        if (!pondering())
+            m_time.check();
         m_state  = M_get_state(
             false, m_stop.load(), m_state.load(),
-            (m_time.get() || m_nodes.load() > m_limits.nodes 
+            (m_time.get() || nodes() > m_limits.nodes
             || depth > m_limits.depth)
         );
     }
 
-    // Check if the stop signal is set
+    // Check if the search should stop
     bool get() const
     {
-        return m_state.load();
+        return m_state.load(std::memory_order_relaxed);
     }
 
     // Update depth
@@ -90,35 +169,30 @@ public:
         );
     }
 
-    // Increment nodes by 1, and check if the search should stop (based on time)
+    // Increment nodes by 1, the limits are checked only every `interval` nodes
     void update()
     {
-        add_nodes(1);
-        m_time.check();
-        m_state = M_get_state(
-            m_ignore.load(), m_stop.load(), m_state.load(),
-            m_time.get()
-        );
-    }
+        uint64_t nodes = m_nodes.load(std::memory_order_relaxed) + 1;
+        m_nodes.store(nodes, std::memory_order_relaxed);
 
-    // Update nodes
-    void add_nodes(uint64_t nodes)
-    {
-        m_nodes += nodes;
-        m_state = M_get_state(
-            m_ignore.load(), m_stop.load(), m_state.load(),
-            m_nodes.load() > m_limits.nodes
-        );
+        if (nodes >= m_next_poll)
+            M_poll(nodes);
     }
 
     // Get the number of nodes searched
     uint64_t nodes() const
     {
-        return m_nodes.load();
+        return m_nodes.load(std::memory_order_relaxed);
+    }
+
+    // Get the current polling interval in nodes
+    uint64_t interval() const
+    {
+        return m_interval;
     }
 
     // Get elapsed time
-    chess::TimeMan::Time time() const
+    Time time() const
     {
         return m_time.elapsed();
     }
@@ -132,4 +206,4 @@ public:
     bool is_ignoring() {return m_ignore.load(); }
 };
 
-}
\ No newline at end of file
+}
@@ -31,6 +31,11 @@ public:
      */
     void setPrint(bool enabled) { m_print_enabled = enabled; }
 
+    /**
+     * @brief Check if the log messages are printed to the console
+     */
+    bool isPrinting() const { return m_print_enabled; }
+
     /**
      * @brief Set the log state flag, if enabled, all log messages are written to the log file
      */
@@ -38,10 +43,10 @@ public:
 
     void setLogFile(std::string logfile);
     void logf(const char* format, ...);
-    void logTTableInfo(TTable<TEntry>* ttable);
+    void logTTableInfo(TranspositionTable* ttable);
     void logBoardInfo(chess::Board* board);
     void logPV(chess::MoveList* pv);
-    void printInfo(int depth, int score, bool cp, uint64_t nodes, uint64_t time, chess::MoveList* pv = nullptr);
+    void printInfo(int depth, int score, bool cp, uint64_t nodes, uint64_t time, chess::MoveList* pv = nullptr, int multipv = 0);
     void printf(const char* format, ...);
 };
 
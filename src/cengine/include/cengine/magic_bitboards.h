@@ -18,13 +18,24 @@ https://www.chessprogramming.org/Looking_for_Magics
 #include "mailbox.h" // for move mailbox move generation
 #include "pieces.h"
 
+// PEXT lookup is compiled in only if the target supports BMI2 (-march=native on BMI2 hardware),
+// it's used only if the cpu has a fast PEXT implementation (see `init_magics`)
+#if defined(__BMI2__) && (defined(__x86_64__) || defined(_M_X64))
+    #define CENGINE_USE_PEXT 1
+    #include <immintrin.h>
+#else
+    #define CENGINE_USE_PEXT 0
+#endif
+
 namespace chess
 {
-// Magic bitboard struct, fancy magic bitboard stuff
+// Magic bitboard struct, fancy magic bitboard stuff,
+// `offset` is the start of the square's slice in the attack table
 struct Magic {
     Bitboard mask;
     Bitboard magic;
     int shift;
+    uint32_t offset = 0;
 };
 
 class MagicBitboards
@@ -33,29 +44,52 @@ public:
     static const int RBits[64];
     static const int BBits[64];
 
-    static Bitboard bishopAttacks[64][512];
-    static Bitboard rookAttacks[64][4096];    
-    
-    static Magic bishopMagics[64];
-    static Magic rookMagics[64];
+    static const std::array<Magic, 64> bishopMagics;
+    static const std::array<Magic, 64> rookMagics;
+
+    // Size of the attack table, sum of 2^BBits + 2^RBits
+    // (the magics use the same number of bits as the masks)
+    static constexpr size_t ATTACK_TABLE_SIZE = 5248 + 102400;
+
+#if CENGINE_USE_PEXT
+    // All bishop and rook attacks, bishop squares first. Generated at compile time indexed
+    // by the magics, `set_pext` refills it in place to be indexed by PEXT (single table)
+    static Table<Bitboard, ATTACK_TABLE_SIZE> attackTable;
+#else
+    // All bishop and rook attacks indexed by the magics, bishop squares first,
+    // generated at compile time
+    static const Table<Bitboard, ATTACK_TABLE_SIZE> attackTable;
+#endif
+    static bool usePext;
 };
 
+bool has_fast_pext();
+bool set_pext(bool enable);
+
 /**
- * @brief Get the bishop attacks, based on the magic bitboards
+ * @brief Get the bishop attacks, based on the magic bitboards (or PEXT if available)
  */
 inline uint64_t bishopAttacks(uint64_t occupied, int sq)
 {
     auto& magic = MagicBitboards::bishopMagics[sq];
-    return MagicBitboards::bishopAttacks[sq][((occupied & magic.mask) * magic.magic) >> magic.shift];
+#if CENGINE_USE_PEXT
+    if (MagicBitboards::usePext)
+        return MagicBitboards::attackTable[magic.offset + _pext_u64(occupied, magic.mask)];
+#endif
+    return MagicBitboards::attackTable[magic.offset + (((occupied & magic.mask) * magic.magic) >> magic.shift)];
 }
 
 /**
- * @brief Get the rook attacks, calculated using magic bitboards
+ * @brief Get the rook attacks, calculated using magic bitboards (or PEXT if available)
  */
 inline uint64_t rookAttacks(uint64_t occupied, int sq)
 {
     auto& magic = MagicBitboards::rookMagics[sq];
-    return MagicBitboards::rookAttacks[sq][((occupied & magic.mask) * magic.magic) >> magic.shift];
+#if CENGINE_USE_PEXT
+    if (MagicBitboards::usePext)
+        return MagicBitboards::attackTable[magic.offset + _pext_u64(occupied, magic.mask)];
+#endif
+    return MagicBitboards::attackTable[magic.offset + (((occupied & magic.mask) * magic.magic) >> magic.shift)];
 }
 
 /**
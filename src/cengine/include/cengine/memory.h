@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#   include <xmmintrin.h>
+#endif
+
+namespace chess
+{
+    // Alignment of the large allocations (2 MB huge page on x86-64)
+    constexpr size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    void* large_alloc(size_t bytes);
+    void large_free(void* ptr, size_t bytes);
+    void parallel_zero(void* ptr, size_t bytes, size_t threads);
+
+    // Hint the CPU to load the cache line with given address
+    inline void prefetch(const void* addr)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(addr);
+#elif defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(addr), _MM_HINT_T0);
+#else
+        (void)addr;
+#endif
+    }
+}
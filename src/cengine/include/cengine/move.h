@@ -424,6 +424,14 @@ public:
      */
     inline bool empty() const {return n_moves == 0;}
 
+    /**
+     * @brief Check if the list contains given move
+     */
+    inline bool contains(const Move& move) const 
+    {
+        return std::find(moves, moves + n_moves, move_t(move)) != moves + n_moves;
+    }
+
     /**
      * @brief Get the move at the given index
      */
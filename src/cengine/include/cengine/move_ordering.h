@@ -1,127 +1,90 @@
 #pragma once
 
-#include <algorithm>
-
 #include "eval.h"
 #include "move.h"
 #include "board.h"
-#include "transp_table.h"
+#include "cache.h"
 
 namespace chess
 {
 
-    // Move ordering for move lists, based on the 
-    // pricipal variation, captures and history heuristic
-    class MoveOrdering
+    /**
+     * @brief Staged move picker, yields the moves one by one in order: hash move,
+     * winning captures, killers, quiet moves and losing captures. The moves are generated
+     * and scored only when their stage is reached, so a beta cutoff on the hash move
+     * or a capture skips the quiet move generation entirely.
+     */
+    class MovePicker
     {
     public:
-        MoveOrdering() = default;
-
-        // Class to give value to moves, giving priority to PV moves, captures and history heuristic
-        class OrderedMove
+        enum Stage
         {
-            static inline int captured_value(Move m, Board* b)
-            {
-                // The value of the captured piece
-                return Eval::piece_values[Piece::getType(b->board[m.getTo()]) - 1] 
-                    - Eval::piece_values[Piece::getType(b->board[m.getFrom()]) - 1];
-            }
-
-        public:
-            Move move = Move::nullMove;
-            int value = 0;
-
-            OrderedMove() = default;
-
-            /**
-             * @brief Set the move and its value
-             * @param m Move to set the Value
-             * @param pvm hash move for this position (null-move if non-existent)
-             * @param b board state
-             * @param sc search cache has history and killer heuristic stored  
-             * @param ply Current distance from the `root` position
-             * @param danger Enemy attacks bitboard
-             * @param endgame_factor Generated by Eval, from 0 - `MAX_ENDGAME_FACTOR`, 
-             * indicates how close the game is to endgame
-             * @param middlegame_factor `MAX_ENDGAME_FACTOR` - endgame_factor
-             */
-            inline void set(
-                const Move& m, const Move& pvm, 
-                Board* b, SearchCache* sc, Depth ply,
-                int endgame_factor, int middlegame_factor
-            )
-            {
-                constexpr int 
-                    bias_multipier       = 10000,
-                    pv_bias              = 100 * bias_multipier,
-                    winning_capture_bias = 8 * bias_multipier,
-                    killer_bias          = 4 * bias_multipier,
-                    promotion_bias       = 3 * bias_multipier,
-                    losing_capture_bias  = 2 * bias_multipier,
-                    regular_bias         = 0;
+            TT_MOVE = 0,
+            GEN_CAPTURES,
+            GOOD_CAPTURES,
+            KILLERS,
+            GEN_QUIETS,
+            QUIET_MOVES,
+            BAD_CAPTURES,
+
+            // Quiescence search stages, captures only
+            QS_TT_MOVE,
+            QS_GEN_CAPTURES,
+            QS_CAPTURES,
+
+            DONE
+        };
 
-                move  = m;
-                value = regular_bias;
+        static constexpr int
+            bias_multipier  = 10000,
+            promotion_bias  = 3 * bias_multipier;
 
-                auto from         = m.getFrom();
-                auto to           = m.getTo();
-                auto moving_piece = b->board[from];
-                auto piece_type   = Piece::getType(moving_piece);
-                auto turn         = b->turn();
+        MovePicker(Board& board, SearchCache* sc, Move tt_move, Depth ply, MoveList* legal = nullptr);
+        MovePicker(Board& board, Move tt_move = Move::nullMove);
 
-                // Add the pricipal variation bias (if the move is pv move)
-                value += (pvm == m) * pv_bias;
-                
-                // If that's a capture, apply biases, and add the delta
-                // So that, the moves will be ordered with captures 
-                // of least valuable pieces capturing most valuable pieces
-                if (m.isCapture())
-                {
-                    auto delta = captured_value(m, b);
+        Move next();
 
-                    // Apply capture bias
-                    value += (delta < 0) ? losing_capture_bias : winning_capture_bias;
-                    value += delta;
-                }
-                
-                if (piece_type == Piece::Pawn)
-                    value += (m.isPromotion() && !m.isCapture()) * promotion_bias;                
-                
-                if (piece_type != Piece::King)
-                {
-                    // Add the piece square tables 
-                    // (so the moves that improve the position of the piece are ordered 1st)
-                    auto mid_sq_table = Eval::piece_square_table[turn][Eval::MIDDLE_GAME][piece_type-1];
-                    auto end_sq_table = Eval::piece_square_table[turn][Eval::ENDGAME][piece_type-1];
+        /**
+         * @brief Get the current stage of the picker
+         */
+        inline int stage() const { return m_stage; }
 
-                    value += (mid_sq_table[to] - mid_sq_table[from]) * middlegame_factor
-                        + (end_sq_table[to] - mid_sq_table[from]) * endgame_factor;
-                    
-                    // Check if we are moving into attacked squares
-                    if ((b->m_danger & to) != 0)
-                        value -= 50;
-                    if ((b->m_enemy_activity[Board::PAWN_TYPE] & to) != 0)
-                        value -= 100;
-                }
+    private:
+        void M_generate(GenType gen);
+        void M_score_captures();
+        void M_score_quiets();
+        Move M_select_best();
+        bool M_is_yielded(Move m) const;
 
-                // Evaluate the quiet moves, based on killer and history heuristic
-                if (!m.isCapture())
-                {
-                    value += sc->getKH().is_killer(m, ply) * killer_bias;
-                    value += sc->getHH().get(b->turn(), m);
-                }
-            }
-        };
+        /**
+         * @brief Check if the generated move is legal (the moves from the legal list always are)
+         */
+        inline bool M_is_legal(Move m) { return m_legal || m_board.isLegalAfter(m); }
 
-        // Get the greater value of two moves
-        static constexpr bool greater(const OrderedMove& __x, const OrderedMove& __y)
+        /**
+         * @brief Value of the capture, victim - attacker (king captures are always safe,
+         * since it may only capture undefended pieces)
+         */
+        inline int M_captured_value(Move m) const
         {
-            return __x.value > __y.value;
+            int victim   = m.isEnPassant() ? Piece::Pawn : Piece::getType(m_board[m.getTo()]);
+            int attacker = Piece::getType(m_board[m.getFrom()]);
+            return Eval::piece_values[victim - 1]
+                - (attacker == Piece::King ? 0 : Eval::piece_values[attacker - 1]);
         }
 
-        /**
-         * @brief Order the moves in the move list, modifies the list in place
-         */
-        static void sort(MoveList *ml, Move pv, Board *b, SearchCache* sc, Depth ply = 0);
+        Board&        m_board;
+        SearchCache*  m_sc;
+        MoveList*     m_legal;
+        Move          m_tt_move;
+        Move          m_killers[KillerHeuristic::MOVES_PER_PLY];
+        Depth         m_ply;
+        int           m_stage;
+        int           m_killer_index;
+        size_t        m_cur;
+        size_t        m_end;
+        size_t        m_bad_end;
+        MoveList      m_moves;
+        int           m_scores[MoveList::MAX_MOVES];
     };
-}
\ No newline at end of file
+}
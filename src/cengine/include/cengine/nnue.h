@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+
+#include "types.h"
+
+namespace chess
+{
+    class Board;
+
+    /**
+     * ## NNUE
+     *
+     * Efficiently updatable neural network evaluation, HalfKA-style feature transformer
+     * (king bucket x piece x square, for both perspectives) followed by a clipped ReLU
+     * and a single output neuron. The network is loaded from a file, if there is no
+     * network (or it's disabled) the handcrafted `Eval::evaluate` is used.
+     *
+     * File format (little endian):
+     *  - "CENN" magic, uint32 version, uint32 hidden size, uint32 number of king buckets
+     *  - int16 feature weights [N_FEATURES][HIDDEN], int16 feature biases [HIDDEN]
+     *  - int16 output weights [2 * HIDDEN] (side to move first), int32 output bias
+     */
+    class NNUE
+    {
+    public:
+        static constexpr uint32_t VERSION    = 1;
+        static constexpr int      N_BUCKETS  = 4;
+        static constexpr int      N_FEATURES = N_BUCKETS * 2 * 6 * 64;
+        static constexpr int      HIDDEN     = 256;
+        static constexpr int      QA         = 255;
+        static constexpr int      QB         = 64;
+        static constexpr int      SCALE      = 400;
+
+        // Inference kernels, selected at startup based on the cpu features
+        enum Kernel
+        {
+            SCALAR = 0,
+            SSE41,
+            AVX2
+        };
+
+        // Single change of the board features, a piece added or removed from a square
+        struct Delta
+        {
+            uint8_t add;
+            uint8_t is_white;
+            uint8_t type;
+            uint8_t sq;
+        };
+
+        // Hidden layer values for both perspectives, one entry per ply,
+        // computed lazily from the parent entry and the deltas
+        struct alignas(64) Accumulator
+        {
+            static constexpr int MAX_DELTAS = 6;
+
+            int16_t values[2][HIDDEN];
+            bool    computed[2];
+            bool    refresh[2];
+            uint8_t n_deltas;
+            Delta   deltas[MAX_DELTAS];
+
+            // Values are not initialized on purpose, they are filled on evaluation
+            Accumulator() : computed{false, false}, refresh{true, true}, n_deltas(0) {}
+
+            inline void add(bool is_white, int type, Square sq)
+            {
+                deltas[n_deltas++] = Delta{1, uint8_t(is_white), uint8_t(type), uint8_t(sq)};
+            }
+
+            inline void remove(bool is_white, int type, Square sq)
+            {
+                deltas[n_deltas++] = Delta{0, uint8_t(is_white), uint8_t(type), uint8_t(sq)};
+            }
+        };
+
+        struct Network
+        {
+            alignas(64) int16_t ft_weights[N_FEATURES * HIDDEN];
+            alignas(64) int16_t ft_biases[HIDDEN];
+            alignas(64) int16_t out_weights[2 * HIDDEN];
+            int32_t out_bias;
+        };
+
+        NNUE() = delete;
+
+        static void init();
+        static bool load(const std::string& file);
+        static void unload();
+        static int evaluate(Board& board);
+        static bool setKernel(Kernel kernel);
+        static const char* kernelName();
+
+        /**
+         * @brief Check if the network is loaded and enabled, the board keeps
+         * its accumulators only in that case
+         */
+        static inline bool active() { return s_active; }
+
+        /**
+         * @brief Check if the network is loaded
+         */
+        static inline bool loaded() { return s_network != nullptr; }
+
+        /**
+         * @brief Enable or disable the network evaluation (if loaded)
+         */
+        static inline void setEnabled(bool enabled)
+        {
+            s_enabled = enabled;
+            s_active  = enabled && loaded();
+        }
+
+        /**
+         * @brief Get the loaded network file, empty if none
+         */
+        static inline const std::string& file() { return s_file; }
+
+        /**
+         * @brief Get the king bucket of given perspective, the king square is
+         * oriented so that own pieces start on the last ranks (56 - 63)
+         */
+        static inline int kingBucket(bool perspective, Square king)
+        {
+            Square ksq = perspective ? king : king ^ 56;
+            return ((ksq >> 3) < 6 ? 2 : 0) + ((ksq & 7) >= 4);
+        }
+
+        /**
+         * @brief Get the feature index of a piece, from given perspective
+         * @param type piece type index (0 - 5)
+         */
+        static inline int featureIndex(bool perspective, int bucket, bool is_white, int type, Square sq)
+        {
+            Square osq = perspective ? sq : sq ^ 56;
+            return bucket * 768 + ((is_white != perspective) * 6 + type) * 64 + osq;
+        }
+
+    private:
+        static void M_refresh(Board& board, Accumulator& acc, bool perspective);
+        static void M_update(const Accumulator& prev, Accumulator& acc, bool perspective, int bucket);
+
+        static inline std::unique_ptr<Network> s_network;
+        static inline std::string s_file;
+        static inline bool s_enabled = true;
+        static inline bool s_active  = false;
+    };
+}
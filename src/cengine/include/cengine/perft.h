@@ -1,28 +1,93 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include "board.h"
 
 // Benchmarking namespace mainly for perft test
 namespace bench
 {
+    /**
+     * @brief Perft transposition table, stores the node count of a position
+     * at given depth. Entries are lockless (the key is xored with the data),
+     * so the table can be shared by all perft threads
+     */
+    class PerftTable
+    {
+    public:
+        struct Entry
+        {
+            std::atomic<uint64_t> key{0};
+            std::atomic<uint64_t> data{0}; // nodes << 8 | depth
+        };
+
+        PerftTable(size_t sizeMB);
+
+        bool probe(chess::Hash hash, int depth, uint64_t& nodes) const;
+        void store(chess::Hash hash, int depth, uint64_t nodes);
+
+    private:
+        inline const Entry& M_entry(chess::Hash hash, int depth) const
+        {
+            // Mix the depth into the index, so that the same position
+            // at different depths doesn't replace each other
+            return m_table[(hash ^ (uint64_t(depth) * 0x9E3779B97F4A7C15ULL)) & m_mask];
+        }
+
+        std::unique_ptr<Entry[]> m_table;
+        uint64_t m_mask;
+    };
+
     // Perft test
     class Perft
     {
-        template <bool>
-        uint64_t perft(int depth);
-
-        bool m_print;
-        chess::Board m_board;
     public:
+        // Default size of the perft hash table in MB
+        static constexpr size_t DEFAULT_HASH_SIZE = 64;
+
+        // Position of the perft suite, with the expected node count at given depth
+        struct SuiteEntry
+        {
+            std::string fen;
+            int depth;
+            uint64_t nodes;
+        };
 
-        Perft(bool print = true);
+        Perft(bool print = true, size_t threads = 1, size_t hash = DEFAULT_HASH_SIZE);
         Perft &operator=(Perft &&other);
 
-        uint64_t run(int depth = 6, std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"); 
+        uint64_t run(int depth = 6, std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        bool suite(int max_depth = 4);
+
+        static std::vector<SuiteEntry> parseSuite(const std::string& epd, int max_depth);
 
         /**
          * @brief Set if the perft test should print the results
          */
         void setPrint(bool print) { m_print = print; }
+
+        /**
+         * @brief Set the number of threads, root moves are split between them
+         */
+        void setThreads(size_t threads) { m_threads = std::max(threads, size_t(1)); }
+
+        /**
+         * @brief Set the size of the hash table in MB (0 disables hashing),
+         * the table is allocated on the next run
+         */
+        void setHashSize(size_t hash) { m_hash_size = hash; m_table.reset(); }
+
+    private:
+        static uint64_t perft(chess::Board& board, int depth, PerftTable* table);
+
+        bool m_print;
+        size_t m_threads;
+        size_t m_hash_size;
+        std::unique_ptr<PerftTable> m_table;
+        chess::Board m_board;
     };
-}
\ No newline at end of file
+
+    // Standard perft positions (EPD with ';D<depth> <nodes>' entries)
+    extern const char* perft_suite;
+}
@@ -78,19 +78,72 @@ namespace chess
     };
 
 
-    // Search thread
+    // Search statistics, collected by each thread
+    struct SearchStats
+    {
+        // Number of transposition table probes
+        uint64_t tt_probes = 0;
+
+        SearchStats& operator+=(const SearchStats& other)
+        {
+            tt_probes += other.tt_probes;
+            return *this;
+        }
+    };
+
+    // Search thread, with id 0 it's the main thread (prints the search info and
+    // the best move), otherwise it's a Lazy SMP helper sharing the transposition table
     class Thread
     {
     public:
         static constexpr int MAX_PLY = 64;
-
-        Thread();
+        // Quiescence search goes at most this many plies beyond the main search
+        // (captures only, there are at most 30 pieces to capture)
+        static constexpr int MAX_QSEARCH_PLY = 32;
+        static constexpr int STACK_SIZE      = MAX_PLY + MAX_QSEARCH_PLY;
+
+        // Triangular principal variation table, the row at `ply` holds the best line
+        // from the node at that ply, the PV nodes fill it when a move raises alpha
+        class PVTable
+        {
+        public:
+            static constexpr int SIZE = MAX_PLY + 1;
+
+            // Clear the line of the node at given ply
+            void clear(Depth ply) { m_length[ply] = ply; }
+
+            // Set the line at given ply to `move` followed by the line of the child node
+            void update(Depth ply, Move move)
+            {
+                m_moves[ply][ply] = move;
+                for (int i = ply + 1; i < m_length[ply + 1]; i++)
+                    m_moves[ply][i] = m_moves[ply + 1][i];
+                m_length[ply] = m_length[ply + 1];
+            }
+
+            // Get the line from the node at given ply
+            MoveList line(Depth ply = 0) const
+            {
+                MoveList pv;
+                for (int i = ply; i < m_length[ply]; i++)
+                    pv.add(m_moves[ply][i]);
+                return pv;
+            }
+
+        private:
+            Move m_moves[SIZE][SIZE];
+            int  m_length[SIZE];
+        };
+
+        Thread(int id = 0);
         ~Thread();
 
         void setup(Board& board, SearchCache& search_cache, Limits& limits);
-        void start_thinking(Board& board, SearchCache& search_cache, Limits limits);
+        void start_thinking(Board& board, SearchCache& search_cache, Limits limits, 
+                            std::vector<Thread*> helpers = {});
         void iterative_deepening();
         void stop();
+        void ponderhit();
         void join();
 
         // Returns true if the thread is thinking
@@ -99,6 +152,15 @@ namespace chess
         // Get the atomic Result object
         shared_data<Result>& get_result() { return m_best_result; }
 
+        // Number of nodes searched by this thread
+        uint64_t nodes() const { return m_interrupt.nodes(); }
+
+        // Get the thread id, 0 is the main thread
+        int id() const { return m_id; }
+
+        // Get the statistics of the last search
+        const SearchStats& stats() const { return m_stats; }
+
     private:
 
         Value qsearch(Board& board, Value alpha, Value beta, Depth depth);
@@ -106,18 +168,28 @@ namespace chess
         template <NodeType>
         Value search(Board& board, Value alpha, Value beta, Depth depth, Depth ply = 0, bool nmp = true);
 
-        MoveList get_pv(int max_depth = 10);
+        void prefetch(Board& board, Move move);
         Move get_pv_move(Depth& ply);
+        bool skip_depth(Depth depth) const;
+        uint64_t total_nodes() const;
+        Thread* vote();
 
+        int m_id;
         Board m_board;
         SearchCache *m_search_cache;
         SearchStack m_ss;
         Limits m_limits;
         Interrupt m_interrupt;
         Result m_result;
+        Value m_root_value;
         Depth m_depth;
-        Depth m_root_age;
         MoveList m_root_pv;
+        PVTable m_pv;
+        MoveList m_root_excluded; // root moves of the lines already found in this iteration (MultiPV)
+        size_t m_pv_index;        // index of the searched line (MultiPV)
+        std::vector<Thread*> m_helpers;
+        SearchStats m_stats;
+        Position m_positions[STACK_SIZE]; // positions saved before making the moves, by ply
 
         std::thread m_thread;
         std::atomic<bool> m_thinking;
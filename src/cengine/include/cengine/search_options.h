@@ -52,15 +52,25 @@ inline void update_score(Score& score, int eval, int whotomove, int pv_length =
     }
 }
 
-// Search result
+// Single line of the MultiPV search
+struct Line
+{
+    Move bestmove = Move::nullMove;
+    Score score   = {Score::cp, 0};
+    MoveList pv   = {};
+};
+
+// Search result, `bestmove`, `score` and `pv` are the ones of the best line,
+// `lines` has all of the MultiPV lines (best first)
 struct Result
 {
-    Move bestmove      = Move::nullMove;
-    Score score        = {Score::cp, 0};
-    MoveList pv        = {};
-    Termination status = NONE;
-    Depth depth        = 0;
-    uint64_t nodes     = 0;
+    Move bestmove           = Move::nullMove;
+    Score score             = {Score::cp, 0};
+    MoveList pv             = {};
+    Termination status      = NONE;
+    Depth depth             = 0;
+    uint64_t nodes          = 0;
+    std::vector<Line> lines = {};
 };
 
 // Contains search limits
@@ -78,6 +88,9 @@ typedef struct
 
     // Pondering
     bool ponder = false;
+
+    // Number of lines to search (MultiPV), set by the engine
+    size_t multipv = 1;
 } Limits;
 
 // Main object to handle search options
@@ -105,6 +118,7 @@ public:
         static void setBtime(Limits& params, value_t value) { params.time.time[0] = value; }
         static void setWinc(Limits& params, value_t value) { params.time.inc[1] = value; }
         static void setBinc(Limits& params, value_t value) { params.time.inc[0] = value; }
+        static void setMovestogo(Limits& params, value_t value) { params.time.movestogo = value; }
 
         // Constructors
         Option(fn_setter_t setter = defaultSetter) : m_setter(setter), m_limits(nullptr) {}
@@ -151,6 +165,7 @@ public:
         m_options["btime"]    = Option(Option::setBtime, &m_limits);
         m_options["winc"]     = Option(Option::setWinc, &m_limits);
         m_options["binc"]     = Option(Option::setBinc, &m_limits);
+        m_options["movestogo"] = Option(Option::setMovestogo, &m_limits);
     }
 
     /**
@@ -234,7 +249,8 @@ private:
         if (lhs_limits.time.time[0] != rhs_limits.time.time[0] ||
             lhs_limits.time.time[1] != rhs_limits.time.time[1] ||
             lhs_limits.time.inc[0] != rhs_limits.time.inc[0] ||
-            lhs_limits.time.inc[1] != rhs_limits.time.inc[1])
+            lhs_limits.time.inc[1] != rhs_limits.time.inc[1] ||
+            lhs_limits.time.movestogo != rhs_limits.time.movestogo)
             return false;
         
         // Limits are equal
@@ -10,6 +10,22 @@
 
 namespace chess
 {
+    // Incrementally updated evaluation terms, indexed by color (1 - white, 0 - black)
+    struct Accumulator
+    {
+        int16_t psq[2][2];   // piece square table sums, [color][middlegame/endgame]
+        int16_t material[2]; // material of the pieces (without the king)
+        int16_t phase;       // sum of the endgame factors of the pieces (both colors)
+
+        constexpr friend bool operator==(const Accumulator& lhs, const Accumulator& rhs)
+        {
+            return lhs.psq[0][0] == rhs.psq[0][0] && lhs.psq[0][1] == rhs.psq[0][1]
+                && lhs.psq[1][0] == rhs.psq[1][0] && lhs.psq[1][1] == rhs.psq[1][1]
+                && lhs.material[0] == rhs.material[0] && lhs.material[1] == rhs.material[1]
+                && lhs.phase == rhs.phase;
+        }
+    };
+
     // Struct to store the state of the game
     typedef struct State
     {
@@ -17,6 +33,7 @@ namespace chess
         {
             return (
                     lhs.hash                == rhs.hash
+                && lhs.pawn_hash            == rhs.pawn_hash
                 && lhs.move                 == rhs.move
                 && lhs.side_to_move         == rhs.side_to_move
                 && lhs.captured_piece       == rhs.captured_piece
@@ -25,21 +42,51 @@ namespace chess
                 && lhs.fullmove_counter     == rhs.fullmove_counter
                 && lhs.castling_rights      == rhs.castling_rights
                 && lhs.irreverisble_index   == rhs.irreverisble_index
+                && lhs.acc                  == rhs.acc
             );
         }
 
         uint64_t hash; // 64 bits for Zobrist hash
+        uint64_t pawn_hash; // 64 bits for Zobrist hash of the pawn structure
         uint64_t move:Move::bits; // 16 bits
         uint64_t side_to_move:Piece::bits; // 5 bit for side to move (Piece::Color)
         uint64_t captured_piece:Piece::bits; // 5 bits for piece
         uint64_t enpassant_target:6; // 6 bits for square (0 - 63)
-        uint64_t halfmove_clock:6; // 6 bits for halfmove clock (0 - 63 (max is 50))
-        uint64_t fullmove_counter:13; // 13 bits for fullmove counter (0 - 8192)
+        uint64_t halfmove_clock:10; // 10 bits for halfmove clock (0 - 1023, the draw is claimed at 100)
+        uint64_t fullmove_counter:18; // 18 bits for fullmove counter (0 - 262143)
         uint64_t castling_rights:CastlingRights::bits; // 4 bits for castling rights
-        uint64_t irreverisble_index:9; // 9 bits for the index of the last irreversible move
-        // That gives total of 128 bits, instead of 6*32 + 64 = 256 bits
+        // The fields above pack into a single 64-bit word, 192 bits with the hashes
+        Accumulator acc; // 112 bits for the evaluation accumulator
+        uint16_t irreverisble_index; // index of the last irreversible move, fits in the padding
     } State;
 
+    // 192 bits + 112 bits (accumulator) + 16 bits (irreversible index) = 320 bits
+    static_assert(sizeof(Accumulator) == 14, "Accumulator should be 14 bytes");
+    static_assert(sizeof(State) == 40, "State should be 40 bytes");
+
     // Vector of 'State' structs, representing the game history
     typedef std::vector<State> StateList;
+
+    /**
+     * @brief Part of the board that changes when making a move (without the history and the
+     * network accumulators). It's trivially copyable, so the search saves it before making
+     * the moves and restores it instead of undoing them (copy-make), see `Board::restore`
+     */
+    struct Position
+    {
+        Bitboard m_bitboards[2][6]; // [is_white][type - 1], contains bitboards for each piece type
+        Bitboard m_pinned; // pieces of the side to move pinned to the king, see `Board::updateChecks`
+        Hash m_hash;
+        Hash m_pawn_hash;
+        Accumulator m_acc;
+        int8_t board[64];
+        bool m_in_check;
+        int m_side;
+        int m_enpassant_target;
+        int m_halfmove_clock;
+        int m_fullmove_counter;
+        int m_captured_piece;
+        int m_irreversible_index; // last irreversible move index
+        CastlingRights m_castling_rights;
+    };
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <limits>
@@ -18,6 +19,8 @@ struct TimeLimits
     uint64_t time[2] = {0, 0};
     // Increment for white and black [black, white]
     uint64_t inc[2]  = {0, 0};
+    // Moves to the next time control, 0 if the whole game must be played with the given time
+    uint64_t movestogo = 0;
     // Infinite search, i.e. search until stop signal
     bool infinite    = false;
 };
@@ -29,11 +32,31 @@ struct TimeLimits
 The `TimeMan` class is used to manage the time in the game while
 searching for the best move.
 
+#### Allocation
+
+With the clock limits (wtime/btime, winc/binc, movestogo) the time manager
+allocates two budgets for the move, see `init`:
+- optimum: the search won't start a new iteration after it's used,
+- maximum: hard limit, the search is stopped in the middle of the iteration.
+
+With `movetime` both budgets are equal to it.
+
 #### Prediction
 
 This feature is used to predict the time taken to search a given
 depth. Engine may decide whether to stop the search or not, based
-on the time taken to search a given depth.
+on the time taken to search a given depth: the next iteration takes
+about as much longer as the last one took compared to the one before.
+
+#### Extensions
+
+The optimum time is extended when the best move changes between
+the iterations or the score drops.
+
+#### Pondering
+
+While pondering the search runs on the opponent's time, the budgets
+are counted from the `ponderhit` (see `ponderhit`).
 
 */
 class TimeMan
@@ -54,9 +77,18 @@ public:
         return std::chrono::high_resolution_clock::now();
     }
 
+    // Time reserved for the communication with the GUI, per move (in milliseconds)
+    static constexpr Time MOVE_OVERHEAD = 30;
+    // Expected number of moves left in the game, if `movestogo` is not given
+    static constexpr Time DEFAULT_MOVES_TO_GO = 30;
+
     /// Constructors
-    TimeMan(): m_stop(false), m_limits({}), m_start_time(now()) {}
-    TimeMan(const TimeLimits& limits): m_stop(false), m_limits(limits), m_start_time(now()) {}
+    TimeMan(): TimeMan(TimeLimits{}) {}
+    TimeMan(const TimeLimits& limits): m_stop(false), m_limits(limits), m_start_time(now()) 
+    {
+        m_optimum = m_maximum = limits.movetime;
+    }
+
     TimeMan(const TimeMan& other)
     {
         *this = other;
@@ -64,16 +96,120 @@ public:
 
     TimeMan& operator=(const TimeMan& other)
     {
-        m_stop       = other.m_stop.load();
-        m_limits     = other.m_limits;
-        m_start_time = other.m_start_time;
+        m_stop        = other.m_stop.load();
+        m_limits      = other.m_limits;
+        m_start_time  = other.m_start_time;
+        m_clock_start = other.m_clock_start;
+        m_managed     = other.m_managed;
+        m_optimum     = other.m_optimum;
+        m_maximum     = other.m_maximum;
+        m_iter_start  = other.m_iter_start;
+        m_last_iter   = other.m_last_iter;
+        m_prev_iter   = other.m_prev_iter;
+        m_instability = other.m_instability;
+        m_score_drop  = other.m_score_drop;
+        m_prev_score  = other.m_prev_score;
+        m_has_score   = other.m_has_score;
         return *this;
     }
 
+    /**
+     * @brief Allocate the time for the move of given side, from the remaining clock,
+     * increment and moves to go (does nothing if the clock of the side isn't set)
+     */
+    void init(bool is_white)
+    {
+        const Time time = m_limits.time[is_white];
+        const Time inc  = m_limits.inc[is_white];
+
+        m_managed = time > 0 && !m_limits.infinite;
+        if (!m_managed)
+            return;
+
+        const Time mtg  = m_limits.movestogo ? std::min<Time>(m_limits.movestogo, 50) : DEFAULT_MOVES_TO_GO;
+        const Time safe = std::max<Time>(time > MOVE_OVERHEAD ? time - MOVE_OVERHEAD : 0, 1);
+
+        // Last move before the time control may use all of the time
+        if (mtg == 1)
+        {
+            m_optimum = m_maximum = safe;
+        }
+        else
+        {
+            m_optimum = std::min(safe / mtg + inc * 3 / 4, safe / 2);
+            m_maximum = std::min(m_optimum * 4, safe * 4 / 5);
+        }
+
+        m_optimum = std::max<Time>(std::min(m_optimum, m_limits.movetime), 1);
+        m_maximum = std::max<Time>(std::min(m_maximum, m_limits.movetime), 1);
+    }
+
+    /**
+     * @brief Record the completed iteration of the iterative deepening
+     * @param best_changed true if the best move differs from the previous iteration
+     * @param score score of the iteration (side to move perspective)
+     */
+    void iteration(bool best_changed, Value score)
+    {
+        const Time time = elapsed();
+        m_prev_iter     = m_last_iter;
+        m_last_iter     = time - m_iter_start;
+        m_iter_start    = time;
+        m_instability   = m_instability / 2 + (best_changed ? 1.0 : 0.0);
+        m_score_drop    = m_has_score ? std::max(m_prev_score - score, 0) : 0;
+        m_prev_score    = score;
+        m_has_score     = true;
+    }
+
+    /**
+     * @brief Predict the time of the next iteration, based on the growth of the last two
+     */
+    Time predict() const
+    {
+        double growth = m_prev_iter ? double(m_last_iter) / double(m_prev_iter) : 2.0;
+        return Time(double(m_last_iter) * std::clamp(growth, 1.5, 4.0));
+    }
+
+    /**
+     * @brief Check if the iterative deepening should stop before the next iteration:
+     * the (extended) optimum time is used, or the next iteration is predicted not to finish
+     * before the maximum time. Always false without the clock limits.
+     */
+    bool stop_iterating() const
+    {
+        if (!m_managed)
+            return false;
+
+        const double scale = (1.0 + 0.5 * m_instability) * std::clamp(1.0 + m_score_drop / 100.0, 1.0, 2.0);
+        const Time   time  = used();
+        return time >= std::min(Time(double(m_optimum) * scale), m_maximum) 
+            || time + predict() >= m_maximum;
+    }
+
+    /**
+     * @brief The opponent played the expected move, our clock starts now,
+     * the time spent pondering doesn't count to the budgets nor to the iteration times
+     */
+    void ponderhit()
+    {
+        m_clock_start = elapsed();
+        m_iter_start  = m_clock_start;
+        m_last_iter   = 0;
+        m_prev_iter   = 0;
+    }
+
+    // Get the optimum time for this move in milliseconds
+    Time optimum() const { return m_optimum; }
+
+    // Get the maximum time for this move in milliseconds
+    Time maximum() const { return m_maximum; }
+
     // Start the timer
     void start()
     {
-        m_start_time = std::chrono::high_resolution_clock::now();
+        m_start_time  = std::chrono::high_resolution_clock::now();
+        m_clock_start = 0;
+        m_iter_start  = 0;
     }
 
     // See if the game should stop
@@ -85,22 +221,8 @@ public:
         if (m_limits.infinite)
             return;
 
-        auto time = elapsed();
-
-        if (time >= m_limits.movetime)
+        if (used() >= m_maximum)
             m_stop = true;
-
-        // if (time >= m_limits.time[side])
-        //     m_stop = true;
-    }
-
-    // Update the time, increment the time (if any)
-    void update()
-    {
-        // if (m_limits.infinite)
-        //     return;
-
-        // m_limits.time[side] += m_limits.inc[side];
     }
 
     // Get the time elapsed in milliseconds
@@ -110,10 +232,27 @@ public:
         return duration_cast<milliseconds>(now() - m_start_time).count();
     } 
 
+    // Get the time used from our clock in milliseconds (elapsed since the ponderhit, if pondering)
+    Time used() const
+    {
+        return elapsed() - m_clock_start;
+    }
+
 private:
     std::atomic_bool m_stop;
     TimeLimits m_limits;
     time_point m_start_time;
+    Time m_clock_start   = 0;
+    bool m_managed       = false;
+    Time m_optimum       = 0;
+    Time m_maximum       = 0;
+    Time m_iter_start    = 0;
+    Time m_last_iter     = 0;
+    Time m_prev_iter     = 0;
+    double m_instability = 0;
+    Value m_score_drop   = 0;
+    Value m_prev_score   = 0;
+    bool m_has_score     = false;
 };
 
 }
\ No newline at end of file
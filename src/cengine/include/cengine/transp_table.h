@@ -1,9 +1,13 @@
 #pragma once
 
 #include <unordered_map>
+#include <algorithm>
+#include <vector>
+#include <bit>
 
 #include "move.h"
 #include "types.h"
+#include "memory.h"
 
 
 // Stores, just the hash.
@@ -22,25 +26,6 @@ struct DepthBasedEntry : public BaseTTEntry
     chess::Depth depth : 16;
 };
 
-// Transposition table entry (for search)
-// hash: Zobrist hash of the position
-// depth: Depth of the search
-// nodeType: Type of node (exact, lowerbound, upperbound)
-// score: Score of the position
-// bestMove: Best move found
-// age: Age of the entry
-struct TEntry : public DepthBasedEntry
-{
-    static constexpr int EXACT = 0; // Exact score
-    static constexpr int LOWERBOUND = 1; // Lower bound (on beta cutoff)
-    static constexpr int UPPERBOUND = 2; // Upper bound (on alpha cutoff)
-
-    int nodeType : 3;
-    int score    : 29;
-    chess::Move bestMove;
-};
-
-
 template <typename T>
 concept isTTEntry = std::is_base_of<BaseTTEntry, T>::value;
 
@@ -53,15 +38,15 @@ public:
     typedef typename std::is_base_of<DepthBasedEntry, T> isDepthBased; 
     typedef typename std::vector<T> TableType;
 
-    // Function to get the key to table, based on the hash and max_size
-    static constexpr int get_key(uint64_t hash, uint64_t max_size) {
-        return hash % max_size;
+    // Function to get the key to table, based on the hash and max_size (power of 2)
+    static constexpr uint64_t get_key(uint64_t hash, uint64_t max_size) {
+        return hash & (max_size - 1);
     }
 
-    // Constructor with size in MB of the table
+    // Constructor with size in MB of the table, number of entries is rounded down to a power of 2
     TTable(size_t sizeMB = 1) noexcept 
     {
-        m_max_size = sizeMB * (1 << 20) / sizeof(T);
+        m_max_size = std::bit_floor(std::max(sizeMB * (1 << 20) / sizeof(T), size_t(1)));
         m_table.resize(m_max_size);
         clear();
     }
@@ -118,6 +103,12 @@ public:
         return m_table[get_key(hash, m_max_size)];
     }
 
+    // Load the entry for given hash into the cache
+    inline void prefetch(uint64_t hash) const noexcept
+    {
+        chess::prefetch(&m_table[get_key(hash, m_max_size)]);
+    }
+
     // Returns vector of entries 
     inline TableType& getTable() noexcept 
     {
@@ -169,4 +160,195 @@ private:
 
     TableType    m_table;
     uint64_t  m_max_size;
-};
\ No newline at end of file
+};
+
+
+// Transposition table entry (for search), 12 bytes
+// score: Score of the position
+// key: upper 16 bits of the Zobrist hash, xored with the rest of the entry
+// bestMove: Best move found
+// eval: Static evaluation of the position
+// depth: Depth of the search
+// genbound: Generation of the search (upper 6 bits) and node type (lower 2 bits)
+struct TEntry
+{
+    static constexpr int NONE       = 0; // Empty entry
+    static constexpr int EXACT      = 1; // Exact score
+    static constexpr int LOWERBOUND = 2; // Lower bound (on beta cutoff)
+    static constexpr int UPPERBOUND = 3; // Upper bound (on alpha cutoff)
+
+    int32_t     score    = 0;
+    uint16_t    key      = 0;
+    chess::Move bestMove = chess::Move::nullMove;
+    int16_t     eval     = 0;
+    int8_t      depth    = 0;
+    uint8_t     genbound = 0;
+
+    // Type of the node (exact, lowerbound, upperbound), NONE if the entry is empty
+    int nodeType() const { return genbound & 0x3; }
+
+    // Generation of the search that stored this entry
+    uint8_t generation() const { return genbound >> 2; }
+
+    // Fold the data of this entry into 16 bits, used to verify the entry,
+    // since the entries are written without any locks
+    uint16_t data_key() const 
+    {
+        return uint16_t(score) ^ uint16_t(uint32_t(score) >> 16) 
+            ^ bestMove.get() ^ uint16_t(eval) ^ (uint16_t(uint8_t(depth)) | uint16_t(genbound) << 8);
+    }
+};
+
+// Cluster of entries, fits in a single cache line
+struct alignas(64) TCluster
+{
+    static constexpr int N_ENTRIES = 5;
+    TEntry entries[N_ENTRIES];
+    char padding[64 - N_ENTRIES * sizeof(TEntry)];
+};
+
+static_assert(sizeof(TEntry) == 12, "TEntry should be 12 bytes");
+static_assert(sizeof(TCluster) == 64, "TCluster should be 64 bytes");
+
+// Get the upper 64 bits of the 128-bit product
+constexpr uint64_t mul_hi64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    return uint64_t((unsigned __int128)(a) * b >> 64);
+#else
+    uint64_t a_lo = uint32_t(a), a_hi = a >> 32;
+    uint64_t b_lo = uint32_t(b), b_hi = b >> 32;
+    uint64_t c1   = (a_lo * b_lo) >> 32;
+    uint64_t c2   = a_hi * b_lo + c1;
+    uint64_t c3   = a_lo * b_hi + uint32_t(c2);
+    return a_hi * b_hi + (c2 >> 32) + (c3 >> 32);
+#endif
+}
+
+/*
+
+### Transposition table
+
+Shared between the search threads, without any locks. The table is an array of
+64-byte clusters (aligned, backed by huge pages if possible), the upper bits of 
+the hash select the cluster (multiply-high, so any size in MB can be used)
+and the lower 16 bits are stored in the entry (xored with the entry data, so that
+entries torn by concurrent writes are rejected on probe).
+
+*/
+class TranspositionTable
+{
+public:
+    static constexpr int GENERATION_BITS = 6;
+    static constexpr int GENERATION_MASK = (1 << GENERATION_BITS) - 1;
+
+    TranspositionTable(size_t sizeMB = 1);
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+    ~TranspositionTable();
+
+    bool resize(size_t sizeMB);
+    void clear(size_t threads = 1);
+    int hashfull() const;
+
+    // Start new search, entries from previous searches will be replaced first
+    void new_search() { m_generation = (m_generation + 1) & GENERATION_MASK; }
+
+    // Get the number of entries in the table
+    size_t size() const { return m_count * TCluster::N_ENTRIES; }
+
+    // Get the size of the table in bytes
+    size_t bytes() const { return m_count * sizeof(TCluster); }
+
+    // Get the requested size of the table in MB
+    size_t sizeMB() const { return m_size_mb; }
+
+    /**
+     * @brief Look up the position in the table
+     * @param hash Zobrist hash of the position
+     * @param entry Copy of the found entry
+     * @return true if the entry was found
+     */
+    inline bool probe(uint64_t hash, TEntry& entry) const
+    {
+        const TCluster& cluster = M_cluster(hash);
+        const uint16_t key      = M_key(hash);
+
+        for (int i = 0; i < TCluster::N_ENTRIES; i++)
+        {
+            // Copy the entry first, it may be overwritten by other thread
+            entry = cluster.entries[i];
+            if (entry.nodeType() != TEntry::NONE && (entry.key ^ entry.data_key()) == key)
+                return true;
+        }
+        return false;
+    }
+
+    // Load the cluster for given hash into the cache, before it's probed
+    inline void prefetch(uint64_t hash) const { chess::prefetch(&M_cluster(hash)); }
+
+    /**
+     * @brief Store the search result, will replace the same position entry or 
+     * the least valuable one (shallow and from old searches)
+     */
+    inline void store(uint64_t hash, chess::Depth depth, chess::Value score, int nodeType, chess::Move move, chess::Value eval = 0)
+    {
+        TCluster& cluster = M_cluster(hash);
+        const uint16_t key  = M_key(hash);
+        TEntry* replace     = &cluster.entries[0];
+
+        for (int i = 0; i < TCluster::N_ENTRIES; i++)
+        {
+            TEntry* e = &cluster.entries[i];
+            if (e->nodeType() == TEntry::NONE || (e->key ^ e->data_key()) == key)
+            {
+                // Same position, keep the deeper entry from this search
+                if (e->nodeType() != TEntry::NONE && e->generation() == m_generation 
+                    && nodeType != TEntry::EXACT && depth + 2 < e->depth)
+                    return;
+
+                // Preserve the old best move
+                if (!move && e->nodeType() != TEntry::NONE)
+                    move = e->bestMove;
+                
+                replace = e;
+                break;
+            }
+
+            if (M_worth(*e) < M_worth(*replace))
+                replace = e;
+        }
+
+        TEntry entry;
+        entry.score    = score;
+        entry.bestMove = move;
+        entry.eval     = int16_t(std::clamp(eval, -32767, 32767));
+        entry.depth    = int8_t(std::clamp(depth, 0, 127));
+        entry.genbound = uint8_t(m_generation << 2 | nodeType);
+        entry.key      = key ^ entry.data_key();
+        *replace       = entry;
+    }
+
+private:
+    // Relative age of the entry (number of searches since it was stored)
+    inline int M_age(const TEntry& e) const
+    {
+        return (m_generation - e.generation()) & GENERATION_MASK;
+    }
+
+    // Value of the entry, used in the replacement policy
+    inline int M_worth(const TEntry& e) const
+    {
+        return e.depth - 8 * M_age(e);
+    }
+
+    inline uint16_t M_key(uint64_t hash) const { return uint16_t(hash); }
+
+    inline TCluster& M_cluster(uint64_t hash) { return m_clusters[mul_hi64(hash, m_count)]; }
+    inline const TCluster& M_cluster(uint64_t hash) const { return m_clusters[mul_hi64(hash, m_count)]; }
+
+    TCluster* m_clusters;
+    size_t   m_count;
+    size_t   m_size_mb;
+    uint8_t  m_generation;
+};
@@ -2,6 +2,8 @@
 
 #include "settings.h"
 #include <cstdint>
+#include <cstddef>
+#include <array>
 
 namespace chess
 {
@@ -14,6 +16,23 @@ typedef int Value;
 typedef uint64_t Hash;
 typedef int Depth;
 
+template <typename T, std::size_t N, std::size_t... Ns>
+struct table_type
+{
+    using type = std::array<typename table_type<T, Ns...>::type, N>;
+};
+
+template <typename T, std::size_t N>
+struct table_type<T, N>
+{
+    using type = std::array<T, N>;
+};
+
+// Multidimensional array usable in constant expressions,
+// Table<Bitboard, 2, 64> is the same as Bitboard[2][64]
+template <typename T, std::size_t... N>
+using Table = typename table_type<T, N...>::type;
+
 typedef bool RepetitionType;
 static constexpr RepetitionType Threefold = 0, Fivefold = 1;
 
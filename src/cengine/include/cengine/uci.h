@@ -6,6 +6,7 @@
 
 #include "engine.h"
 #include "threads.h"
+#include "bench.h"
 
 // Universal Chess Interface
 namespace uci
@@ -158,16 +159,29 @@ namespace uci
             }
         };
 
+        // Maximum number of search threads
+        static constexpr int MAX_THREADS = 256;
+        // Maximum size of the transposition table in MB
+        static constexpr int MAX_HASH = 131072;
+        // Maximum size of a single (per thread) pawn table in MB
+        static constexpr int MAX_PAWN_HASH = 1024;
+        // Maximum number of lines in the MultiPV mode
+        static constexpr int MAX_MULTIPV = 256;
+
         std::map<std::string, Option> options;
 
         // Constructor
         UCIOptions()
         {
             options["Log File"]        = Option(std::string(Log::LOG_FILE));
-            options["Hash"]            = Option(chess::SearchCache::DEFAULT_HASH_SIZE, 1, 128);
+            options["Hash"]            = Option(chess::SearchCache::DEFAULT_HASH_SIZE, 1, MAX_HASH);
+            options["Pawn Hash"]       = Option(chess::SearchCache::DEFAULT_PAWN_HASH_SIZE, 1, MAX_PAWN_HASH);
             options["UCI_AnalyseMode"] = Option(false);
-            options["Threads"]         = Option(1, 1, 1);
-            options["MultiPV"]         = Option(1, 1, 1);
+            options["Threads"]         = Option(1, 1, MAX_THREADS);
+            options["MultiPV"]         = Option(1, 1, MAX_MULTIPV);
+            options["Ponder"]          = Option(false);
+            options["EvalFile"]        = Option(std::string());
+            options["UseNNUE"]         = Option(true);
 
             options["Clear Hash"]      = Option(
                 Option::Callback(
@@ -201,7 +215,12 @@ namespace uci
         void apply(chess::Engine& engine)
         {
             engine.setHashSize(options["Hash"].spin().value);
+            engine.setPawnHashSize(options["Pawn Hash"].spin().value);
+            engine.setThreads(options["Threads"].spin().value);
+            engine.setMultiPV(options["MultiPV"].spin().value);
             engine.setLogFile(options["Log File"].string());
+            engine.setUseNNUE(options["UseNNUE"].boolean());
+            engine.setEvalFile(options["EvalFile"].string() == "<empty>" ? "" : options["EvalFile"].string());
         }
 
         // Set option
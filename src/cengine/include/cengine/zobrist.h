@@ -7,15 +7,104 @@
 
 namespace chess
 {
+    /**
+     * @brief Mersenne Twister, generates the same sequence as `std::mt19937`,
+     * but can be used in constant expressions
+     */
+    class MersenneTwister
+    {
+    public:
+        static constexpr int N = 624, M = 397;
+
+        constexpr MersenneTwister(uint32_t seed) : m_state{}, m_index(N)
+        {
+            m_state[0] = seed;
+            for (int i = 1; i < N; i++)
+                m_state[i] = 1812433253u * (m_state[i - 1] ^ (m_state[i - 1] >> 30)) + uint32_t(i);
+        }
+
+        constexpr uint32_t operator()()
+        {
+            if (m_index >= N)
+                M_twist();
+
+            uint32_t y = m_state[m_index++];
+            y ^= y >> 11;
+            y ^= (y << 7) & 0x9d2c5680u;
+            y ^= (y << 15) & 0xefc60000u;
+            y ^= y >> 18;
+            return y;
+        }
+
+        /**
+         * @brief Get the next 64-bit number, same as
+         * `std::uniform_int_distribution<uint64_t>(0, max)` with `std::mt19937`
+         */
+        constexpr uint64_t next64()
+        {
+            uint64_t high = (*this)();
+            return (high << 32) + (*this)();
+        }
+
+    private:
+        constexpr void M_twist()
+        {
+            for (int i = 0; i < N; i++)
+            {
+                uint32_t y = (m_state[i] & 0x80000000u) | (m_state[(i + 1) % N] & 0x7fffffffu);
+                m_state[i] = m_state[(i + M) % N] ^ (y >> 1) ^ ((y & 1) ? 0x9908b0dfu : 0u);
+            }
+            m_index = 0;
+        }
+
+        uint32_t m_state[N];
+        int m_index;
+    };
+
+    // All Zobrist hash keys
+    struct ZobristKeys
+    {
+        Table<Hash, 2, 6, 64> pieces;
+        Table<Hash, 16> castling;
+        Hash turn;
+        Table<Hash, 8> enpassant;
+    };
+
+    /**
+     * @brief Generate the Zobrist hash keys (at compile time), with a fixed seed
+     */
+    constexpr ZobristKeys init_hashing()
+    {
+        constexpr uint32_t seed = 0x12345678;
+
+        MersenneTwister gen(seed);
+        ZobristKeys keys = {};
+
+        for (int k = 0; k < 2; k++)
+            for (int i = 0; i < 6; i++)
+                for (int j = 0; j < 64; j++)
+                    keys.pieces[k][i][j] = gen.next64();
+
+        for (int i = 0; i < 16; i++)
+            keys.castling[i] = gen.next64();
+
+        keys.turn = gen.next64();
+
+        for (int i = 0; i < 8; i++)
+            keys.enpassant[i] = gen.next64();
+
+        return keys;
+    }
+
+    inline constexpr ZobristKeys zobrist_keys = init_hashing();
+
     // Zobrist hash keys
     class Zobrist
     {
     public:
-        static Hash hash_pieces[2][6][64];
-        static Hash hash_castling[16];
-        static Hash hash_turn;
-        static Hash hash_enpassant[8];
+        static constexpr const Table<Hash, 2, 6, 64>& hash_pieces    = zobrist_keys.pieces;
+        static constexpr const Table<Hash, 16>&       hash_castling  = zobrist_keys.castling;
+        static constexpr const Hash&                  hash_turn      = zobrist_keys.turn;
+        static constexpr const Table<Hash, 8>&        hash_enpassant = zobrist_keys.enpassant;
     };
-
-    void init_hashing();
-}
\ No newline at end of file
+}
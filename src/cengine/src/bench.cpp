@@ -0,0 +1,221 @@
+#include <cengine/bench.h>
+
+namespace bench
+{
+
+const std::vector<std::string> positions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r2qk2r/5ppp/p1nbbn2/1p6/Q1Pp4/N4P2/PP1PKP1P/R1B2B1R w kq - 0 15",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r2qr1k1/pp2bp1p/1n1p1np1/P1pP1b2/5P2/2N1P1P1/1P1QN1BP/R1B2RK1 b - - 2 15",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 1 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r1bqkbnr/pp1ppppp/2n5/2p5/2P5/2N3P1/PP1PPP1P/R1BQKBNR b KQkq - 0 3",
+    "6k1/5p2/6p1/8/7p/8/6PP/6K1 b - - 0 1",
+};
+
+// Sample of 'src/utils/openings.txt', searched by the `bench` command after the 'positions' above
+static const std::vector<std::string> openings = {
+    "1r1qk2r/pb2bppp/1p2pn2/2p1p3/2Pn1B2/1PNP2P1/P3NPBP/R2Q1RK1 w k - 0 12",
+    "5rk1/3q1ppp/1prb4/p1np4/3Qn3/4PN2/PB2BPPP/2R2RK1 b - - 1 19",
+    "r1bqk2r/ppp2pp1/2np1n1p/4p3/4P3/P1PP1N2/2P1BPPP/R1BQK2R w KQkq - 0 8",
+    "rnbqkb1r/1pp2pp1/p3pn1p/3p4/3P4/2NBPN2/PPP2PPP/R1BQK2R w KQkq - 0 6",
+    "r2q1rk1/pp3pp1/2n2n1p/6B1/3p4/P2Q4/1PP1NPPP/R4RK1 w - - 0 15",
+    "rn1qr1k1/pp2ppbp/2p2np1/3P2B1/2PP2b1/2NB1N2/PP3PPP/R2Q1R1K b - - 3 10",
+    "r2qkbnr/pp1n1ppp/2p1p3/5b2/3PN3/5N2/PPP1QPPP/R1B1KB1R w KQkq - 2 7",
+    "r1bqkbnr/pp1ppppp/2n5/8/4P3/8/PPP2PPP/RNBQKBNR b KQkq - 2 4",
+    "r1bqk2r/pp1pp1bp/2n2np1/2p2p2/2P2P2/2N2NP1/PP1PP1BP/R1BQK2R w KQkq - 2 7",
+    "r2qr1k1/pp2bppp/2b2n2/2ppN1B1/8/2NP4/PPPQ1PPP/R3R1K1 b - - 1 13",
+    "r2qkb1r/pp1npppp/3p1n2/2p5/4P3/5N2/PPPP1PPP/RNBQ1RK1 w kq - 2 6",
+    "r1bq1rk1/pp3ppp/2n1pn2/8/1bBP4/P1N2N2/1P3PPP/R1BQ1RK1 b - - 0 10",
+    "rn1q1rk1/p4pbp/3p1np1/1pp5/3BP2P/P1N2PPN/1PP5/R2QK2R w KQ - 0 12",
+    "r4rk1/1b3pp1/p1n1pqnp/1pp5/4P3/P1P2N1P/BP3PP1/R1BQ1RK1 w - - 0 16",
+    "rnbqkbnr/pp2pppp/3p4/2p5/8/3P2P1/PPP1PPBP/RNBQK1NR b KQkq - 0 3",
+    "2qr3k/pp3pbp/2b1p1p1/7n/2P2B2/2N2PP1/PPQ3BP/3R3K w - - 2 23",
+    "r4rk1/1p1bbpp1/p1n2Q1p/2p5/8/2PP3P/PP1NBPP1/R3K1NR b KQ - 0 15",
+    "3b2k1/pp3ppp/2n1p3/8/4N3/2P4P/PP2NPP1/6K1 w - - 0 19",
+    "rnbq1rk1/ppp1b1pp/3ppn2/5pB1/8/2PP1NP1/PP2PPBP/RN1QK2R w KQ - 4 7",
+    "r4rk1/pppq1pbp/3p1np1/8/1P1P4/1Q3PP1/PB1N1PKP/R3R3 b - - 0 15",
+    "rnbq1rk1/ppn1bppp/4p3/2PpP3/3P1P2/P4N2/6PP/RNBQKB1R b KQ - 2 10",
+    "2r1r1k1/1b4pp/pp1q1n2/3p1P2/2nN4/1PP3P1/P5BP/RN1QR1K1 b - - 0 24",
+    "r3r1k1/p1p2ppp/2p2b2/5p2/1q1P4/2NQ4/PPP2PPP/2KRR3 w - - 6 17",
+    "rnbqkbnr/pp3ppp/4p3/3p4/4P3/2N5/PP1P1PPP/R1BQKBNR w KQkq - 0 5",
+    "2kr3r/pp1qnppp/3p4/2p5/2PpP1b1/PP1P1NP1/5P1P/R2QKB1R w KQ - 1 13",
+    "r1b2rk1/1p3pbp/p5p1/2Pp2N1/P6P/B1P5/5PP1/R4RK1 w - - 0 18",
+    "6r1/1k6/1p1r4/p3p2p/3nP1p1/P3B3/1R3PPP/1R4K1 w - - 0 30",
+    "1k1r2nr/pppbq1pp/8/3pPp2/8/2PBP1P1/PPQN1PP1/1K1R3R b - - 0 14",
+    "r3n1k1/1pp4p/p1bp2pP/8/2PRPr2/2N2P2/PP4B1/2KR4 b - - 3 21",
+    "rnbqkbnr/pp2pppp/8/2ppP3/8/5N2/PPPP1PPP/RNBQKB1R b KQkq - 0 3",
+    "rnbqkb1r/pp2pppp/5n2/3p2B1/3P4/2N5/PPP2PPP/R2QKBNR b KQkq - 1 5",
+    "rnbqkbnr/pp2pppp/8/2pp4/4P3/3P1N2/PPP2PPP/RNBQKB1R b KQkq - 0 3",
+    "r2qr1k1/1pp2ppp/p2p1n2/3Pb3/4P1b1/2NQ1B1P/PPPB1PP1/R4RK1 b - - 0 13",
+    "r1bqr1k1/bpp2ppp/p1np1n2/4p3/P3P3/2PP1NP1/1P1N1PBP/R1BQ1RK1 w - - 0 10",
+    "rnbqkbnr/pp3ppp/2p5/3p4/3P4/2N2N2/PPP2PPP/R1BQKB1R b KQkq - 1 5",
+    "rnbqk2r/pp3pbp/2p2np1/3Pp1B1/4P3/2N2N2/PPP3PP/R2QKB1R b KQkq - 2 8",
+    "rnbqkbnr/ppp2pp1/7p/3p4/2PP4/8/PP3PPP/RNBQKBNR w KQkq - 0 5",
+    "r1bq1rk1/pp3pbp/2pp1np1/2P5/2P1p3/P1NPPNP1/5PBP/R1BQ1RK1 b - - 0 11",
+    "rnbqkbnr/ppp2ppp/4p3/3p4/3P4/4P3/PPP2PPP/RNBQKBNR w KQkq - 0 3",
+    "r1bqn2k/3r4/ppnp1NQp/2p1pP2/2P1P2P/3P4/PP4B1/R1B2RK1 b - - 0 22",
+    "rnbqkb1r/ppp2ppp/3ppn2/8/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 2 4",
+};
+
+// Positions of the `bench` command, the 'positions' followed by the 'openings'
+const std::vector<std::string> bench_positions = []()
+{
+    std::vector<std::string> fens = positions;
+    fens.insert(fens.end(), openings.begin(), openings.end());
+    return fens;
+}();
+
+Bench::Bench(bool print)
+{
+    m_print = print;
+}
+
+/**
+ * @brief Run a fixed depth search on every `bench_positions` entry, the search cache is cleared
+ * before each position, so with a single thread the node count is deterministic
+ * @param depth Depth of the search
+ * @param hash Size of the transposition table in MB
+ * @param threads Number of search threads
+ * @return Total nodes, time and the signature (hash of node counts and best moves)
+ */
+Bench::Result Bench::run(int depth, size_t hash, size_t threads)
+{
+    using namespace std::chrono;
+
+    Result result;
+    chess::Engine engine;
+    engine.setHashSize(hash);
+    engine.setThreads(threads);
+
+    chess::SearchOptions options;
+    options["depth"] = depth;
+
+    // Silence the search output
+    bool printing = glogger.isPrinting();
+    glogger.setPrint(false);
+
+    // FNV-1a offset basis
+    result.signature = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < bench_positions.size(); i++)
+    {
+        engine.reset();
+        engine.setPosition(bench_positions[i]);
+
+        auto start = high_resolution_clock::now();
+        auto& shared = engine.go(options);
+        engine.join();
+        auto search  = shared.get();
+
+        result.time  += duration_cast<milliseconds>(high_resolution_clock::now() - start).count();
+        result.nodes += search.nodes;
+
+        for (uint64_t v : {search.nodes, uint64_t(search.bestmove.get())})
+            result.signature = (result.signature ^ v) * 0x100000001b3ULL;
+
+        if (m_print)
+            std::cout << "position " << i + 1 << "/" << bench_positions.size() 
+                << " nodes " << search.nodes 
+                << " bestmove " << search.bestmove.uci() << "\n";
+    }
+
+    glogger.setPrint(printing);
+
+    if (m_print)
+    {
+        std::cout << "depth " << depth
+            << " threads " << threads
+            << " time " << result.time
+            << " nodes " << result.nodes
+            << " nps " << result.nodes * 1000 / std::max(result.time, uint64_t(1))
+            << " signature " << std::hex << result.signature << std::dec
+            << "\n";
+    }
+    return result;
+}
+
+TimeToDepth::TimeToDepth(bool print)
+{
+    m_print = print;
+}
+
+/**
+ * @brief Run the search on all benchmark positions with given number of threads
+ */
+TimeToDepth::Entry TimeToDepth::M_run_threads(int depth, size_t threads, size_t hash)
+{
+    using namespace std::chrono;
+
+    Entry entry;
+    entry.threads = threads;
+
+    chess::Engine engine;
+    engine.setHashSize(hash);
+    engine.setThreads(threads);
+
+    chess::SearchOptions options;
+    options["depth"] = depth;
+
+    for (auto& fen : positions)
+    {
+        engine.reset();
+        engine.setPosition(fen);
+
+        auto start = high_resolution_clock::now();
+        auto& result = engine.go(options);
+        engine.join();
+
+        entry.time  += duration_cast<milliseconds>(high_resolution_clock::now() - start).count();
+        entry.nodes += result.get().nodes;
+        entry.stats += engine.stats();
+    }
+
+    return entry;
+}
+
+/**
+ * @brief Run the time-to-depth benchmark, for 1, 2, 4 ... `max_threads` threads
+ * @param depth Depth of the search
+ * @param max_threads Maximum number of threads to test
+ * @param hash Size of the transposition table in MB
+ * @return Results for each number of threads
+ */
+std::vector<TimeToDepth::Entry> TimeToDepth::run(int depth, size_t max_threads, size_t hash)
+{
+    std::vector<Entry> entries;
+    std::vector<size_t> threads;
+
+    for (size_t n = 1; n < max_threads; n *= 2)
+        threads.push_back(n);
+    threads.push_back(std::max(max_threads, size_t(1)));
+
+    // Silence the search output
+    bool printing = glogger.isPrinting();
+    glogger.setPrint(false);
+
+    for (auto n : threads)
+    {
+        entries.push_back(M_run_threads(depth, n, hash));
+
+        if (m_print)
+        {
+            auto& e    = entries.back();
+            auto time  = std::max(e.time, uint64_t(1));
+            std::cout << "threads " << e.threads 
+                << " time " << e.time 
+                << " nodes " << e.nodes
+                << " nps " << e.nodes * 1000 / time
+                << " speedup " << std::setprecision(3) << double(entries.front().time) / double(time)
+                << " ttprobes " << e.stats.tt_probes
+                << "\n";
+        }
+    }
+
+    glogger.setPrint(printing);
+    return entries;
+}
+
+} // namespace bench
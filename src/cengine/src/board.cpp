@@ -1,76 +1,13 @@
 #include <cengine/board.h>
+#include <cengine/eval.h>
 
 
 namespace chess
 {
 
-    // Helper bitboards
-    Bitboard Board::in_between[64][64]  = {0};
-    Bitboard Board::pawnAttacks[2][64]  = {0};
-    Bitboard Board::pieceAttacks[6][64] = {0};
-
     // Starting position
     const char Board::START_FEN[57] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
-
-    // Init board
-    void Board::init_board()
-    {
-        // Initialize the in_between array
-        // Taken from: https://www.chessprogramming.org/Square_Attacked_By
-        // This array gives the squares in-between two squares
-        // For example, in_between[0][8] gives the squares in-between f6 and c3:
-        // . . . . . . . . 8
-        // . . . . . . . . 7
-        // . . . . . . . . 6
-        // . . . . 1 . . . 5
-        // . . . 1 . . . . 4
-        // . . . . . . . . 3
-        // . . . . . . . . 2
-        // . . . . . . . . 1
-        // a b c d e f g h
-
-        const uint64_t m1   = (-1);
-        const uint64_t a2a7 = (0x0001010101010100);
-        const uint64_t b2g7 = (0x0040201008040200);
-        const uint64_t h1b7 = (0x0002040810204080); /* Thanks Dustin, g2b7 did not work for c1-a3 */
-        
-        for(int i = 0; i < 64; i++){
-            for(int j = 0; j < 64; j++){
-                uint64_t btwn, line, rank, file;
-                btwn  = (m1 << i) ^ (m1 << j);
-                file  =   (j & 7) - (i   & 7);
-                rank  =  ((j | 7) -  i) >> 3 ;
-                line  =      (   (file  &  7) - 1) & a2a7; /* a2a7 if same file */
-                line += 2 * ((   (rank  &  7) - 1) >> 58); /* b1g1 if same rank */
-                line += (((rank - file) & 15) - 1) & b2g7; /* b2g7 if same diagonal */
-                line += (((rank + file) & 15) - 1) & h1b7; /* h1b7 if same antidiag */
-                line *= btwn & -btwn; /* mul acts like shift by smaller square */
-                in_between[i][j] = line & btwn;   /* return the bits on that line in-between */
-            }
-        }
-
-        // Init piece attacks
-        for(int i = 0; i < 64; i++)
-        {
-            pieceAttacks[KING_TYPE][i]   = mailboxAttacks(Piece::King - 1, 0, i , false);
-            pieceAttacks[KNIGHT_TYPE][i] = mailboxAttacks(Piece::Knight - 1, 0, i , false);
-            pieceAttacks[BISHOP_TYPE][i] = mailboxAttacks(Piece::Bishop - 1, 0, i, true);
-            pieceAttacks[ROOK_TYPE][i]   = mailboxAttacks(Piece::Rook - 1, 0, i, true);
-            pieceAttacks[QUEEN_TYPE][i]  = mailboxAttacks(Piece::Queen - 1, 0, i, true);
-
-            // Pawn attacks
-            for(int j = 0; j < 2; j++){
-                for(int k = 0; k < 2; k++){
-                    int n = mailbox[mailbox64[i] + pawn_attack_offsets[j][k]];
-                    if(n != -1){
-                        pawnAttacks[j][i] |= 1ULL << n;
-                    }
-                }
-            }
-        }
-    }
-
     // Constructors
 
     Board::Board()
@@ -82,7 +19,11 @@ namespace chess
         memset(m_enemy_activity, 0, sizeof(m_enemy_activity));
 
         m_history.reserve(64);
+        m_keys.reserve(64);
 
+        m_hash               = 0;
+        m_pawn_hash          = 0;
+        m_acc                = {};
         m_side               = Piece::White;
         m_halfmove_clock     = 0;
         m_fullmove_counter   = 1;
@@ -91,6 +32,7 @@ namespace chess
         m_captured_piece     = Piece::Empty;
         m_irreversible_index = 0;
         m_danger             = 0UL;
+        m_pinned             = 0UL;
         m_in_check           = false;
         m_termination        = Termination::NONE;
 
@@ -105,29 +47,18 @@ namespace chess
     Board::Board(std::string fen)
     {
         m_history.reserve(64);
+        m_keys.reserve(64);
         loadFen(fen);
     }
 
     Board& Board::operator=(const Board& other)
     {
         // Copy the board, field order is kept
-
-        m_hash              = other.m_hash;
-        memcpy(board, other.board, sizeof(board));
-        m_in_check           = other.m_in_check;
-        m_side               = other.m_side;
-        m_enpassant_target   = other.m_enpassant_target;
-        m_halfmove_clock     = other.m_halfmove_clock;
-        m_fullmove_counter   = other.m_fullmove_counter;
-        m_captured_piece     = other.m_captured_piece;
+        Position::operator=(other);
         m_history            = other.m_history;
-        m_irreversible_index = other.m_irreversible_index;
-
-        for(int i = 0; i < 2; i++)
-            for(int j = 0; j < 6; j++)
-                m_bitboards[i][j] = other.m_bitboards[i][j];
-        
-        m_danger        = other.m_danger;
+        m_keys               = other.m_keys;
+        m_nnue               = other.m_nnue;
+        m_danger             = other.m_danger;
         
         for (int i = 0; i < 6; i++)
         {
@@ -135,7 +66,6 @@ namespace chess
             m_enemy_activity[i] = other.m_enemy_activity[i];
         }
         
-        m_castling_rights    = other.m_castling_rights;
         m_termination        = other.m_termination;
     
         return *this;
@@ -264,12 +194,17 @@ namespace chess
         m_captured_piece     = Piece::Empty;
         m_termination        = Termination::NONE;
         m_irreversible_index = 0;
+        m_pinned             = 0UL;
 
         // Update bitboards
         m_history.clear();
+        m_keys.clear();
+        m_nnue.clear();
         updateBitboards();
         verify_castling_rights();
         (void)hash();
+        (void)pawnHash();
+        (void)refreshAccumulator();
         push_state(Move());
 
         return true;
@@ -459,6 +394,8 @@ namespace chess
     {        
         return (
                m_hash               == other.m_hash
+            && m_pawn_hash          == other.m_pawn_hash
+            && m_acc                == other.m_acc
             && m_in_check           == other.m_in_check
             && m_side               == other.m_side
             && m_enpassant_target   == other.m_enpassant_target 
@@ -466,10 +403,10 @@ namespace chess
             && m_captured_piece     == other.m_captured_piece
             && m_history            == other.m_history
             && m_irreversible_index == other.m_irreversible_index
-            && memcmp(m_bitboards[0], other.m_bitboards[0], sizeof(m_bitboards[0]))
-            && memcmp(m_bitboards[1], other.m_bitboards[1], sizeof(m_bitboards[1]))
+            && memcmp(m_bitboards[0], other.m_bitboards[0], sizeof(m_bitboards[0])) == 0
+            && memcmp(m_bitboards[1], other.m_bitboards[1], sizeof(m_bitboards[1])) == 0
             && m_danger        == other.m_danger
-            && memcmp(m_activity, other.m_activity, sizeof(m_activity))
+            && memcmp(m_activity, other.m_activity, sizeof(m_activity)) == 0
             && m_castling_rights    == other.m_castling_rights
             && m_termination        == other.m_termination
         );
@@ -609,9 +546,168 @@ namespace chess
         while(white) hash ^= Zobrist::hash_pieces[1][Piece::Pawn - 1][pop_lsb1(white)];
         while(black) hash ^= Zobrist::hash_pieces[0][Piece::Pawn - 1][pop_lsb1(black)];
         
+        m_pawn_hash = hash;
         return hash;
     }
 
+    /**
+     * @brief Recalculate the evaluation accumulator from scratch
+     */
+    const Accumulator& Board::refreshAccumulator()
+    {
+        m_acc = {};
+
+        for(int turn = 0; turn < 2; turn++)
+            for (int type = 0; type < 6; type++)
+            {
+                Bitboard bb = m_bitboards[turn][type];
+                while(bb) add_piece_acc(turn, type, pop_lsb1(bb));
+            }
+
+        return m_acc;
+    }
+
+    /**
+     * @brief Add the piece to the evaluation accumulator
+     * @param type piece type index (0 - 5)
+     */
+    inline void Board::add_piece_acc(bool is_white, int type, Square sq)
+    {
+        if (NNUE::active() && !m_nnue.empty())
+            m_nnue.back().add(is_white, type, sq);
+
+        m_acc.psq[is_white][Eval::MIDDLE_GAME] += Eval::piece_square_table[is_white][Eval::MIDDLE_GAME][type][sq];
+        m_acc.psq[is_white][Eval::ENDGAME]     += Eval::piece_square_table[is_white][Eval::ENDGAME][type][sq];
+
+        if (type == KING_TYPE)
+            return;
+
+        m_acc.material[is_white] += Eval::piece_values[type];
+        m_acc.phase              += Eval::ENDGAME_FACTOR_PIECES[type];
+    }
+
+    /**
+     * @brief Remove the piece from the evaluation accumulator
+     * @param type piece type index (0 - 5)
+     */
+    inline void Board::remove_piece_acc(bool is_white, int type, Square sq)
+    {
+        if (NNUE::active() && !m_nnue.empty())
+            m_nnue.back().remove(is_white, type, sq);
+
+        m_acc.psq[is_white][Eval::MIDDLE_GAME] -= Eval::piece_square_table[is_white][Eval::MIDDLE_GAME][type][sq];
+        m_acc.psq[is_white][Eval::ENDGAME]     -= Eval::piece_square_table[is_white][Eval::ENDGAME][type][sq];
+
+        if (type == KING_TYPE)
+            return;
+
+        m_acc.material[is_white] -= Eval::piece_values[type];
+        m_acc.phase              -= Eval::ENDGAME_FACTOR_PIECES[type];
+    }
+
+    /**
+     * @brief Get the hash of the position after given move, without making it.
+     * Used to prefetch the transposition table
+     */
+    Hash Board::keyAfter(Move move) const
+    {
+        Square from   = move.getFrom();
+        Square to     = move.getTo();
+        bool is_white = m_side == Piece::White;
+        int type      = Piece::getType(board[from]) - 1;
+        int to_type   = move.isPromotion() ? Piece::promotionPieces[move.getPromotionPiece()] - 1 : type;
+        Hash key      = m_hash ^ Zobrist::hash_turn;
+
+        if (move.isCapture())
+        {
+            Square captured = move.isEnPassant() ? to + (is_white ? 8 : -8) : to;
+            key ^= Zobrist::hash_pieces[!is_white][Piece::getType(board[captured]) - 1][captured];
+        }
+
+        if (m_enpassant_target != 0)
+            key ^= Zobrist::hash_enpassant[m_enpassant_target % 8];
+        
+        if (move.isDoubleMove())
+            key ^= Zobrist::hash_enpassant[to % 8];
+
+        // Castling moves the rook as well
+        if (move.isCastle())
+        {
+            const int rooks[2][2][2] = {
+                {{0, 3}, {56, 59}}, // queen castle (from, to), black and white
+                {{7, 5}, {63, 61}}, // king castle
+            };
+            const int* rook = rooks[move.isKingCastle()][is_white];
+            key ^= Zobrist::hash_pieces[is_white][Piece::Rook - 1][rook[0]]
+                ^ Zobrist::hash_pieces[is_white][Piece::Rook - 1][rook[1]];
+        }
+
+        // Castling rights, lost by moving the king or a rook from its corner (as in `makeMove`)
+        CastlingRights rights = m_castling_rights;
+        if (type == Piece::King - 1)
+            rights.remove(is_white ? CastlingRights::WHITE : CastlingRights::BLACK);
+        else if (type == Piece::Rook - 1 && (from == 0 || from == 56))
+            rights.remove(is_white ? CastlingRights::WHITE_QUEEN : CastlingRights::BLACK_QUEEN);
+        else if (type == Piece::Rook - 1 && (from == 7 || from == 63))
+            rights.remove(is_white ? CastlingRights::WHITE_KING : CastlingRights::BLACK_KING);
+
+        if (rights.get() != m_castling_rights.get())
+            key ^= Zobrist::hash_castling[m_castling_rights.get()] ^ Zobrist::hash_castling[rights.get()];
+
+        return key 
+            ^ Zobrist::hash_pieces[is_white][type][from] 
+            ^ Zobrist::hash_pieces[is_white][to_type][to];
+    }
+
+    /**
+     * @brief Get the pawn structure hash after given move, without making it
+     */
+    Hash Board::pawnKeyAfter(Move move) const
+    {
+        Square from   = move.getFrom();
+        Square to     = move.getTo();
+        bool is_white = m_side == Piece::White;
+        Hash key      = m_pawn_hash;
+
+        if (move.isCapture())
+        {
+            Square captured = move.isEnPassant() ? to + (is_white ? 8 : -8) : to;
+            if (Piece::getType(board[captured]) == Piece::Pawn)
+                key ^= Zobrist::hash_pieces[!is_white][Piece::Pawn - 1][captured];
+        }
+
+        if (Piece::getType(board[from]) == Piece::Pawn)
+        {
+            key ^= Zobrist::hash_pieces[is_white][Piece::Pawn - 1][from];
+            if (!move.isPromotion())
+                key ^= Zobrist::hash_pieces[is_white][Piece::Pawn - 1][to];
+        }
+
+        return key;
+    }
+
+    /**
+     * @brief Push a new network accumulator (if the network is active),
+     * should be called before any piece is moved
+     */
+    inline void Board::push_nnue_acc()
+    {
+        if (!NNUE::active())
+            return;
+
+        auto& acc      = m_nnue.emplace_back();
+        acc.refresh[0] = acc.refresh[1] = false;
+    }
+
+    /**
+     * @brief Pop the network accumulators, so that there is at most one per history entry
+     */
+    inline void Board::pop_nnue_acc()
+    {
+        while (m_nnue.size() > m_history.size())
+            m_nnue.pop_back();
+    }
+
     /**
      * @brief Push the current state of the board to the history
      */
@@ -619,6 +715,8 @@ namespace chess
     {
         State state;
         state.hash               = m_hash;
+        state.pawn_hash          = m_pawn_hash;
+        state.acc                = m_acc;
         state.side_to_move       = m_side;
         state.captured_piece     = m_captured_piece;
         state.castling_rights    = m_castling_rights.get();
@@ -629,6 +727,7 @@ namespace chess
         state.irreverisble_index = m_irreversible_index;
 
         m_history.push_back(state);
+        m_keys.push_back(m_hash);
     }
 
     /**
@@ -650,6 +749,140 @@ namespace chess
         return false;
     }
 
+    /**
+     * @brief Check if given move (from the transposition table or killers) is legal
+     * in this position, without generating the moves. The move must have valid flags.
+     */
+    bool Board::isValid(Move move)
+    {
+        if (!move)
+            return false;
+
+        const bool is_white = turn();
+        const int  from     = move.getFrom();
+        const int  to       = move.getTo();
+        const int  flags    = move.getFlags();
+        const int  piece    = board[from];
+        const int  type     = Piece::getType(piece);
+        const int  push     = is_white ? -8 : 8;
+        Bitboard   occ      = occupied();
+        Bitboard   enemy    = occupied(!is_white);
+        Bitboard   to_bb    = 1ULL << to;
+
+        // Moving piece must belong to the side to move, there is no such flag as 0b0110 or 0b0111
+        if (!piece || Piece::getColor(piece) != m_side || flags == 0b0110 || flags == 0b0111)
+            return false;
+
+        // Castling, the king cannot pass through attacked squares
+        if (move.isCastle())
+        {
+            const int  king_start = is_white ? 60 : 4;
+            const bool king_side  = move.isKingCastle();
+            const int  dir        = king_side ? 1 : -1;
+            const int  rook_sq    = king_side ? king_start + 3 : king_start - 4;
+            const uint32_t right  = is_white 
+                ? (king_side ? CastlingRights::WHITE_KING : CastlingRights::WHITE_QUEEN)
+                : (king_side ? CastlingRights::BLACK_KING : CastlingRights::BLACK_QUEEN);
+
+            if (type != Piece::King || from != king_start || to != from + 2 * dir 
+                || !m_castling_rights.has(right) || board[rook_sq] != Piece::createPiece(Piece::Rook, m_side)
+                || (in_between[from][rook_sq] & occ))
+                return false;
+
+            for (int sq = from; sq != to + dir; sq += dir)
+                if (attackersTo(sq, occ) & enemy)
+                    return false;
+            return true;
+        }
+
+        // Validate the target square
+        if (move.isEnPassant())
+        {
+            if (type != Piece::Pawn || !m_enpassant_target || to != m_enpassant_target)
+                return false;
+        }
+        else if (move.isCapture() ? !(enemy & to_bb) : (occ & to_bb) != 0)
+            return false;
+
+        // Validate the moving pattern
+        if (type == Piece::Pawn)
+        {
+            const bool last_rank = is_white ? to < 8 : to >= 56;
+            if (last_rank != move.isPromotion())
+                return false;
+
+            if (move.isCapture())
+            {
+                if (!(pawnAttacks[is_white][from] & to_bb))
+                    return false;
+            }
+            else if (move.isDoubleMove())
+            {
+                const int start_rank = is_white ? 6 : 1;
+                if ((from >> 3) != start_rank || to != from + 2 * push || (occ & (1ULL << (from + push))))
+                    return false;
+            }
+            else if (to != from + push)
+                return false;
+        }
+        else
+        {
+            if (flags != Move::FLAG_NONE && flags != Move::FLAG_CAPTURE)
+                return false;
+
+            Bitboard attacks = 0;
+            switch (type)
+            {
+            case Piece::Knight: attacks = pieceAttacks[KNIGHT_TYPE][from]; break;
+            case Piece::King:   attacks = pieceAttacks[KING_TYPE][from];   break;
+            case Piece::Bishop: attacks = bishopAttacks(occ, from);        break;
+            case Piece::Rook:   attacks = rookAttacks(occ, from);          break;
+            case Piece::Queen:  attacks = queenAttacks(occ, from);         break;
+            }
+
+            if (!(attacks & to_bb))
+                return false;
+        }
+
+        // Check if the king is not attacked after the move
+        Square king = type == Piece::King ? to : bit_scan_forward(m_bitboards[is_white][KING_TYPE]);
+        occ   = (occ ^ (1ULL << from)) | to_bb;
+        enemy &= ~to_bb;
+
+        if (move.isEnPassant())
+        {
+            Bitboard captured = 1ULL << (to - push);
+            occ   ^= captured;
+            enemy ^= captured;
+        }
+
+        return !(attackersTo(king, occ) & enemy);
+    }
+
+    /**
+     * @brief Get the pieces (of both sides) attacking given square, with given occupancy
+     */
+    Bitboard Board::attackersTo(Square sq, Bitboard occupied)
+    {
+        return (pawnAttacks[0][sq] & m_bitboards[1][PAWN_TYPE])
+            | (pawnAttacks[1][sq] & m_bitboards[0][PAWN_TYPE])
+            | (pieceAttacks[KNIGHT_TYPE][sq] & (m_bitboards[0][KNIGHT_TYPE] | m_bitboards[1][KNIGHT_TYPE]))
+            | (pieceAttacks[KING_TYPE][sq] & (m_bitboards[0][KING_TYPE] | m_bitboards[1][KING_TYPE]))
+            | (bishopAttacks(occupied, sq) & (m_bitboards[0][BISHOP_TYPE] | m_bitboards[1][BISHOP_TYPE] | queens()))
+            | (rookAttacks(occupied, sq) & (m_bitboards[0][ROOK_TYPE] | m_bitboards[1][ROOK_TYPE] | queens()));
+    }
+
+    /**
+     * @brief Get the enemy pieces giving check to the side to move,
+     * cheaper than generating the moves (doesn't update the `inCheck` flag)
+     */
+    Bitboard Board::checkers()
+    {
+        const bool is_white = turn();
+        Square king = bit_scan_forward(m_bitboards[is_white][KING_TYPE]);
+        return attackersTo(king, occupied()) & occupied(!is_white);
+    }
+
     // ------------- TERMINATION CHECKS -------------
 
     /**
@@ -690,13 +923,15 @@ namespace chess
     template <RepetitionType type>
     bool Board::isRepetition()
     {
-        if (m_history.empty())
-            return false;
-        
-        int count = 0;
-        for (int i = m_history.size() - 1; i >= m_irreversible_index; i -= 2)
+        // Current position is the last key, the same position may occur
+        // again only after at least 4 reversible plies
+        const int last = int(m_keys.size()) - 1;
+        const int end  = std::min(m_halfmove_clock, last - m_irreversible_index);
+        int count = 1;
+
+        for (int i = 4; i <= end; i += 2)
         {
-            if (m_history[i].hash == m_hash)
+            if (m_keys[last - i] == m_hash)
                 count++;
         }
         
@@ -714,6 +949,63 @@ namespace chess
         return m_termination != Termination::NONE;
     }
 
+    /**
+     * @brief Check if the position is a draw by repetition in the search,
+     * a single repetition is enough if it occurred after the root (at given ply),
+     * otherwise the position must have already been repeated (threefold)
+     * @param ply distance from the search root
+     */
+    bool Board::isRepetition(int ply) const
+    {
+        const int last = int(m_keys.size()) - 1;
+        const int end  = std::min(m_halfmove_clock, last - m_irreversible_index);
+        bool repeated = false;
+
+        for (int i = 4; i <= end; i += 2)
+        {
+            if (m_keys[last - i] != m_hash)
+                continue;
+
+            if (i < ply || repeated)
+                return true;
+            repeated = true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Check if the side to move can repeat a position from the search tree with
+     * a single reversible move (upcoming repetition), using the cuckoo tables.
+     * The positions before the root are skipped, they need the threefold repetition
+     * @param ply distance from the search root
+     */
+    bool Board::hasUpcomingRepetition(int ply) const
+    {
+        const int last = int(m_keys.size()) - 1;
+        const int end  = std::min({m_halfmove_clock, ply - 1, last - m_irreversible_index});
+        if (end < 3)
+            return false;
+
+        Bitboard occupied = 0;
+        for (int i = 0; i < 6; i++)
+            occupied |= m_bitboards[0][i] | m_bitboards[1][i];
+
+        for (int i = 3; i <= end; i += 2)
+        {
+            Hash move_key = m_hash ^ m_keys[last - i];
+            int  slot     = Cuckoo::h1(move_key);
+            if (cuckoo.keys[slot] != move_key)
+                slot = Cuckoo::h2(move_key);
+            if (cuckoo.keys[slot] != move_key)
+                continue;
+
+            // The path of the move must be empty
+            int from = cuckoo.moves[slot] & 63, to = cuckoo.moves[slot] >> 6;
+            if (!(in_between[from][to] & occupied))
+                return true;
+        }
+        return false;
+    }
 
     /**
      * @brief Check if the board is in a draw by insufficient material
@@ -790,6 +1082,7 @@ namespace chess
     void Board::makeNullMove()
     {
         // Push the current state to the history
+        push_nnue_acc();
         push_state(Move());
 
         // Change the side to move
@@ -821,6 +1114,8 @@ namespace chess
         bool is_white       = Piece::isWhite(board[from]);
         const int rights[2] = { CastlingRights::BLACK, CastlingRights::WHITE };
 
+        push_nnue_acc();
+
         // Update fullmove counter
         if(m_side == Piece::Black){
             m_fullmove_counter++;
@@ -856,9 +1151,12 @@ namespace chess
 
             // Delete the captured piece from the bitboard
             m_bitboards[!is_white][captured_type] &= ~(1ULL << (captured_pos));
+            remove_piece_acc(!is_white, captured_type, captured_pos);
 
             // Update zobrist hash, remove the captured piece
             m_hash ^= Zobrist::hash_pieces[!is_white][captured_type][captured_pos];
+            if (captured_type == Piece::Pawn - 1)
+                m_pawn_hash ^= Zobrist::hash_pieces[!is_white][captured_type][captured_pos];
         }
 
         // Reset the enpassant target square
@@ -903,6 +1201,8 @@ namespace chess
 
             // Update the bitboard for the rook
             updateBitboard(is_white, Piece::Rook - 1, rook_from, rook_to);
+            remove_piece_acc(is_white, ROOK_TYPE, rook_from);
+            add_piece_acc(is_white, ROOK_TYPE, rook_to);
 
             // Update zobrist hash, remove the rook from the old position and add it to the new position
             m_hash ^= Zobrist::hash_pieces[is_white][Piece::Rook - 1][rook_from];
@@ -927,12 +1227,15 @@ namespace chess
             board[from] = promo_type | m_side;
             m_bitboards[is_white][Piece::Pawn - 1] &= ~(1ULL << from); // remove the pawn
             m_bitboards[is_white][promo_type - 1]  |= 1ULL << from; // add the promoted piece (not moved)
+            remove_piece_acc(is_white, PAWN_TYPE, from);
+            add_piece_acc(is_white, promo_type - 1, from);
             m_irreversible_index = m_history.size();
             type = promo_type; // update this, since in the end we will update the bitboard, based on the type
 
             // Update zobrist hash by removing the pawn and adding the promoted piece
             m_hash ^= Zobrist::hash_pieces[is_white][Piece::Pawn - 1][from];
             m_hash ^= Zobrist::hash_pieces[is_white][promo_type - 1][from];
+            m_pawn_hash ^= Zobrist::hash_pieces[is_white][Piece::Pawn - 1][from];
         }
 
         // Update castling rights
@@ -973,16 +1276,27 @@ namespace chess
         // Update the bitboard for the moved piece
         m_bitboards[is_white][type - 1] &= ~(1ULL << from);
         m_bitboards[is_white][type - 1] |= 1ULL << to;
+        remove_piece_acc(is_white, type - 1, from);
+        add_piece_acc(is_white, type - 1, to);
 
         // Update zobrist hash, remove the piece from the old position and add it to the new position
         m_hash ^= Zobrist::hash_pieces[is_white][type - 1][from];
         m_hash ^= Zobrist::hash_pieces[is_white][type - 1][to];
 
+        if (type == Piece::Pawn)
+            m_pawn_hash ^= Zobrist::hash_pieces[is_white][type - 1][from] 
+                ^ Zobrist::hash_pieces[is_white][type - 1][to];
+
         m_side = Piece::opposite(m_side);
 
         // Update zobrist hash, change the side to move
         m_hash ^= Zobrist::hash_turn;
 
+        // King changed its bucket, the network features of this side must be recalculated
+        if (type == Piece::King && NNUE::active()
+            && NNUE::kingBucket(is_white, from) != NNUE::kingBucket(is_white, to))
+            m_nnue.back().refresh[is_white] = true;
+
         push_state(move);
     }
 
@@ -995,9 +1309,11 @@ namespace chess
             return;
         
         m_history.pop_back();
+        m_keys.pop_back();
         State state = m_history.back();
 
         restore_state(state);
+        pop_nnue_acc();
     }
     
     /**
@@ -1006,6 +1322,8 @@ namespace chess
     inline void Board::restore_state(State& history)
     {
         m_hash               = history.hash;
+        m_pawn_hash          = history.pawn_hash;
+        m_acc                = history.acc;
         m_side               = history.side_to_move;
         m_halfmove_clock     = history.halfmove_clock;
         m_enpassant_target   = history.enpassant_target;
@@ -1041,6 +1359,7 @@ namespace chess
         
         // Get the last state
         m_history.pop_back();
+        m_keys.pop_back();
         State history = m_history.back();
 
         Square to           = move.getTo();
@@ -1113,6 +1432,32 @@ namespace chess
 
         // Restore other states
         restore_state(history);
+        pop_nnue_acc();
+    }
+
+    /**
+     * @brief Undo the last move (or null move) by restoring the position saved
+     * before making it, cheaper than `undoMove` (copy-make)
+     */
+    void Board::restore(const Position& position)
+    {
+        m_history.pop_back();
+        m_keys.pop_back();
+        Position::operator=(position);
+        m_termination = Termination::NONE;
+        pop_nnue_acc();
+    }
+
+    /**
+     * @brief Reserve space for given number of moves in the history
+     * (and the network accumulators), so that making them doesn't allocate
+     */
+    void Board::reserve(size_t plies)
+    {
+        m_history.reserve(m_history.size() + plies);
+        m_keys.reserve(m_keys.size() + plies);
+        if (NNUE::active())
+            m_nnue.reserve(m_history.size() + plies);
     }
 
     /**
@@ -1228,7 +1573,7 @@ namespace chess
     /**
      * @brief Generate sliding moves for a given piece type when king isn't in check
      */
-    template<int PieceType>
+    template<GenType gen, int PieceType>
     void Board::_gen_sliding_moves_no_check(
         chess::MoveList* moves, Bitboard piece_bb,
         uint64_t occupied, uint64_t enemy_pieces, 
@@ -1258,7 +1603,10 @@ namespace chess
                 int pinner_sq = getPinner(pinners, sq, king);
                 bmoves &= chess::Board::in_between[pinner_sq][king];
                 captures &= (1ULL << pinner_sq);
-            }            
+            }
+
+            if constexpr (gen == CAPTURES) bmoves   = 0;
+            if constexpr (gen == QUIETS)   captures = 0;
 
             while(bmoves) moves->add(Move::fmove(sq, pop_lsb1(bmoves), Move::FLAG_NONE));
             while(captures) moves->add(Move::fmove(sq, pop_lsb1(captures), Move::FLAG_CAPTURE));
@@ -1268,7 +1616,7 @@ namespace chess
     /**
      * @brief Generate moves for pieces (without pawn & king), when king is in check
      */
-    template<int PieceType>
+    template<GenType gen, int PieceType>
     void Board::_gen_pieces_moves_in_check(
         chess::MoveList* moves, Bitboard piece_bb,
         uint64_t occupied, uint64_t attackers, uint64_t not_pinned, 
@@ -1295,6 +1643,9 @@ namespace chess
 
             m_activity[PieceType] |= (captures | block_moves);
 
+            if constexpr (gen == CAPTURES) block_moves = 0;
+            if constexpr (gen == QUIETS)   captures    = 0;
+
             // If that's a capture, add the move
             if (captures){
                 moves->add(Move::fmove(sq, attackers_sq, Move::FLAG_CAPTURE));
@@ -1319,19 +1670,37 @@ namespace chess
      */
     MoveList Board::generateLegalCaptures()
     {
-        return generateLegalMoves().captures();
+        return generateLegalMoves<CAPTURES>();
+    }
+
+    /**
+     * @brief Generate all legal non-capture moves (including quiet promotions)
+     */
+    MoveList Board::generateLegalQuiets()
+    {
+        return generateLegalMoves<QUIETS>();
     }
 
     /**
      * @brief Generate evasion moves (for king only)
      */
-    inline MoveList Board::generateEvasions(Bitboard danger)
+    template <GenType gen>
+    MoveList Board::generateEvasions(Bitboard danger)
+    {
+        return turn() ? _gen_evasions<Piece::White, gen>(danger) : _gen_evasions<Piece::Black, gen>(danger);
+    }
+
+    /**
+     * @brief Generate the king moves of given side to the squares not in `danger`
+     */
+    template <int Us, GenType gen>
+    MoveList Board::_gen_evasions(Bitboard danger)
     {
         // Generate king moves
         // King can only move to evade the check
         m_activity[KING_TYPE] = 0UL;
         MoveList moves;
-        bool is_white         = turn();
+        constexpr bool is_white = Us == Piece::White;
         Bitboard occupied     = this->occupied();
         Bitboard enemy_pieces = this->occupied(!is_white);
         Square   king         = bit_scan_forward(m_bitboards[is_white][Piece::King - 1]);
@@ -1339,6 +1708,10 @@ namespace chess
         Bitboard captures     = Board::pieceAttacks[Board::KING_TYPE][king] & enemy_pieces & ~danger;
 
         m_activity[KING_TYPE] = (kmoves | captures);
+
+        if constexpr (gen == CAPTURES) kmoves   = 0;
+        if constexpr (gen == QUIETS)   captures = 0;
+
         while(kmoves) moves.add(Move::fmove(king, pop_lsb1(kmoves), Move::FLAG_NONE));
         while(captures) moves.add(Move::fmove(king, pop_lsb1(captures), Move::FLAG_CAPTURE));
         
@@ -1349,11 +1722,21 @@ namespace chess
      * @brief Generate all attacked squares by enemy pieces
      */
     Bitboard Board::generateDanger()
+    {
+        return turn() ? _gen_danger<Piece::White>() : _gen_danger<Piece::Black>();
+    }
+
+    /**
+     * @brief Generate all squares attacked by the enemy of given side,
+     * the king of that side doesn't block the sliders
+     */
+    template <int Us>
+    Bitboard Board::_gen_danger()
     {
         m_danger                 = 0UL;
         memset(m_enemy_activity, 0, sizeof(m_enemy_activity));
-        bool is_white            = turn();
-        bool is_enemy            = !is_white;
+        constexpr bool is_white  = Us == Piece::White;
+        constexpr bool is_enemy  = !is_white;
         Bitboard occupied_noking = occupied() ^ m_bitboards[is_white][Piece::King - 1];
         Bitboard enemy_king      = m_bitboards[is_enemy][Piece::King - 1];
 
@@ -1393,15 +1776,289 @@ namespace chess
         return m_danger;
     }
 
+    /**
+     * @brief Update the check flag and the pinned pieces of the side to move,
+     * needed by `isLegalAfter` (the legal move generation sets them too)
+     */
+    void Board::updateChecks()
+    {
+        const bool is_white    = turn();
+        const Square king      = bit_scan_forward(m_bitboards[is_white][KING_TYPE]);
+        const Bitboard occ     = occupied();
+        const Bitboard allied  = occupied(is_white);
+
+        m_in_check = (attackersTo(king, occ) & (occ ^ allied)) != 0;
+        m_pinned   = 0;
+
+        Bitboard pinner = xRayRookAttacks(occ, allied, king) & oppRooksQueens(is_white);
+        while(pinner) m_pinned |= Board::in_between[pop_lsb1(pinner)][king] & allied;
+
+        pinner = xRayBishopAttacks(occ, allied, king) & oppBishopsQueens(is_white);
+        while(pinner) m_pinned |= Board::in_between[pop_lsb1(pinner)][king] & allied;
+    }
+
+    /**
+     * @brief Check if the pseudo-legal move (from `generatePseudoLegalMoves`) doesn't leave the king
+     * in check. Uses the pin mask, so `updateChecks` must be called for this position first.
+     */
+    bool Board::isLegalAfter(Move move)
+    {
+        const bool   is_white = turn();
+        const Square from     = move.getFrom();
+        const Square to       = move.getTo();
+        const Square king     = bit_scan_forward(m_bitboards[is_white][KING_TYPE]);
+
+        // Castling squares are checked by the generator
+        if (move.isCastle())
+            return true;
+
+        // King moves, en passant and evasions, check the attackers after the move
+        if (from == king || move.isEnPassant() || m_in_check)
+        {
+            Bitboard occ   = (occupied() ^ (1ULL << from)) | (1ULL << to);
+            Bitboard enemy = occupied(!is_white) & ~(1ULL << to);
+
+            if (move.isEnPassant())
+            {
+                Bitboard captured = 1ULL << (to + (is_white ? 8 : -8));
+                occ   ^= captured;
+                enemy ^= captured;
+            }
+            return !(attackersTo(from == king ? to : king, occ) & enemy);
+        }
+
+        // Pinned piece may move only along the pin line
+        return !(m_pinned & (1ULL << from))
+            || (Board::in_between[king][to] & (1ULL << from))
+            || (Board::in_between[king][from] & (1ULL << to));
+    }
+
+    /**
+     * @brief Generate the moves of given piece type (except the pawns and the king) to the target squares
+     */
+    template<int PieceType>
+    void Board::_gen_piece_moves(MoveList& moves, Bitboard pieces, Bitboard occupied, Bitboard enemy, Bitboard targets)
+    {
+        while (pieces)
+        {
+            Square   sq = pop_lsb1(pieces);
+            Bitboard attacks;
+
+            if constexpr (PieceType == KNIGHT_TYPE) attacks = pieceAttacks[KNIGHT_TYPE][sq];
+            if constexpr (PieceType == BISHOP_TYPE) attacks = bishopAttacks(occupied, sq);
+            if constexpr (PieceType == ROOK_TYPE)   attacks = rookAttacks(occupied, sq);
+            if constexpr (PieceType == QUEEN_TYPE)  attacks = queenAttacks(occupied, sq);
+
+            attacks          &= targets;
+            Bitboard captures = attacks & enemy;
+            Bitboard quiets   = attacks ^ captures;
+
+            while (captures) moves.add(Move::fmove(sq, pop_lsb1(captures), Move::FLAG_CAPTURE));
+            while (quiets)   moves.add(Move::fmove(sq, pop_lsb1(quiets), Move::FLAG_NONE));
+        }
+    }
+
+    /**
+     * @brief Generate the pawn moves set-wise: shift the whole pawn bitboard, then serialize
+     * the target squares. En passant is not generated.
+     * @tparam Us side to move (Piece::White or Piece::Black)
+     * @param push_targets allowed target squares of the pushes
+     * @param capture_targets allowed target squares of the captures
+     * @return squares attacked by the pawns
+     */
+    template<int Us, GenType gen>
+    Bitboard Board::_gen_pawn_moves(MoveList& moves, Bitboard pawns, Bitboard occupied, Bitboard push_targets, Bitboard capture_targets)
+    {
+        constexpr bool     is_white    = Us == Piece::White;
+        constexpr int      push        = is_white ? -8 : 8;
+        constexpr Bitboard promo_rank  = is_white ? 0xFFULL << 8 : 0xFFULL << 48;  // 7th rank (relative)
+        constexpr Bitboard double_rank = is_white ? 0xFFULL << 40 : 0xFFULL << 16; // 3rd rank (relative)
+        constexpr Bitboard not_file_a  = ~0x0101010101010101ULL;
+        constexpr Bitboard not_file_h  = ~0x8080808080808080ULL;
+
+        auto shift = [](Bitboard b, int n) { return n > 0 ? b << n : b >> -n; };
+        const Bitboard promoting = pawns & promo_rank;
+        pawns ^= promoting;
+
+        if constexpr (gen != CAPTURES)
+        {
+            Bitboard single = shift(pawns, push) & ~occupied;
+            Bitboard dbl    = shift(single & double_rank, push) & ~occupied & push_targets;
+            single &= push_targets;
+
+            while (single) { Square to = pop_lsb1(single); moves.add(Move::fmove(to - push, to, Move::FLAG_NONE)); }
+            while (dbl)    { Square to = pop_lsb1(dbl);    moves.add(Move::fmove(to - 2 * push, to, Move::FLAG_DOUBLE_PAWN)); }
+
+            Bitboard promos = shift(promoting, push) & ~occupied & push_targets;
+            while (promos)
+            {
+                Square to = pop_lsb1(promos);
+                moves.add(Move::fmove(to - push, to, Move::FLAG_ROOK_PROMOTION));
+                moves.add(Move::fmove(to - push, to, Move::FLAG_BISHOP_PROMOTION));
+                moves.add(Move::fmove(to - push, to, Move::FLAG_KNIGHT_PROMOTION));
+                moves.add(Move::fmove(to - push, to, Move::FLAG_QUEEN_PROMOTION));
+            }
+        }
+
+        // Captures towards the 'a' file (west) and the 'h' file (east)
+        Bitboard west = shift(pawns & not_file_a, push - 1);
+        Bitboard east = shift(pawns & not_file_h, push + 1);
+        Bitboard promo_west = shift(promoting & not_file_a, push - 1);
+        Bitboard promo_east = shift(promoting & not_file_h, push + 1);
+        const Bitboard attacks = west | east | promo_west | promo_east;
+
+        if constexpr (gen != QUIETS)
+        {
+            west &= capture_targets;
+            east &= capture_targets;
+            while (west) { Square to = pop_lsb1(west); moves.add(Move::fmove(to - push + 1, to, Move::FLAG_CAPTURE)); }
+            while (east) { Square to = pop_lsb1(east); moves.add(Move::fmove(to - push - 1, to, Move::FLAG_CAPTURE)); }
+
+            promo_west &= capture_targets;
+            promo_east &= capture_targets;
+            for (int dir = 0; dir < 2; dir++)
+            {
+                Bitboard& captures = dir ? promo_east : promo_west;
+                while (captures)
+                {
+                    Square to   = pop_lsb1(captures);
+                    Square from = to - push + (dir ? -1 : 1);
+                    moves.add(Move::fmove(from, to, Move::FLAG_ROOK_PROMOTION_CAPTURE));
+                    moves.add(Move::fmove(from, to, Move::FLAG_BISHOP_PROMOTION_CAPTURE));
+                    moves.add(Move::fmove(from, to, Move::FLAG_KNIGHT_PROMOTION_CAPTURE));
+                    moves.add(Move::fmove(from, to, Move::FLAG_QUEEN_PROMOTION_CAPTURE));
+                }
+            }
+        }
+        return attacks;
+    }
+
+    /**
+     * @brief Generate the pseudo-legal moves of given side, the moves may leave the king in check
+     * (see `isLegalAfter`), castling is always legal. The pawn moves are generated set-wise.
+     * @tparam Us side to move (Piece::White or Piece::Black)
+     * @tparam gen all moves, captures, quiets or evasions (king moves and the moves
+     * capturing or blocking a single checker)
+     */
+    template<int Us, GenType gen>
+    void Board::_gen_pseudo_legal(MoveList& moves)
+    {
+        constexpr bool  is_white = Us == Piece::White;
+        const Bitboard* bb       = m_bitboards[is_white];
+        const Bitboard  occupied = this->occupied();
+        const Bitboard  enemy    = this->occupied(!is_white);
+        const Square    king     = bit_scan_forward(bb[KING_TYPE]);
+
+        // Target squares of the pieces and the king
+        Bitboard targets      = gen == CAPTURES ? enemy : gen == QUIETS ? ~occupied : enemy | ~occupied;
+        Bitboard king_targets = targets;
+
+        if constexpr (gen == EVASIONS)
+        {
+            // Capture the checker or block the check, in double check only the king may move
+            Bitboard checkers = attackersTo(king, occupied) & enemy;
+            targets = (checkers & (checkers - 1)) ? 0 
+                : checkers | Board::in_between[bit_scan_forward(checkers)][king];
+        }
+
+        _gen_piece_moves<KNIGHT_TYPE>(moves, bb[KNIGHT_TYPE], occupied, enemy, targets);
+        _gen_piece_moves<BISHOP_TYPE>(moves, bb[BISHOP_TYPE], occupied, enemy, targets);
+        _gen_piece_moves<ROOK_TYPE>(moves, bb[ROOK_TYPE], occupied, enemy, targets);
+        _gen_piece_moves<QUEEN_TYPE>(moves, bb[QUEEN_TYPE], occupied, enemy, targets);
+
+        // Pawns, set-wise
+        _gen_pawn_moves<Us, gen>(moves, bb[PAWN_TYPE], occupied, targets, enemy & targets);
+
+        if constexpr (gen != QUIETS)
+        {
+            // En passant, always generated (it may also evade a check), validated by `isLegalAfter`
+            if (m_enpassant_target)
+            {
+                Bitboard attackers = Board::pawnAttacks[!is_white][m_enpassant_target] & bb[PAWN_TYPE];
+                while (attackers)
+                    moves.add(Move::fmove(pop_lsb1(attackers), m_enpassant_target, Move::FLAG_ENPASSANT_CAPTURE));
+            }
+        }
+
+        // King moves, the evasions may go to any square not occupied by own pieces
+        if constexpr (gen == EVASIONS)
+            king_targets = ~(occupied ^ enemy);
+
+        Bitboard kmoves   = Board::pieceAttacks[KING_TYPE][king] & king_targets;
+        Bitboard captures = kmoves & enemy;
+        kmoves ^= captures;
+        while (captures) moves.add(Move::fmove(king, pop_lsb1(captures), Move::FLAG_CAPTURE));
+        while (kmoves)   moves.add(Move::fmove(king, pop_lsb1(kmoves), Move::FLAG_NONE));
+
+        if constexpr (gen == CAPTURES || gen == EVASIONS)
+            return;
+
+        // Castling, the king cannot pass through the attacked squares (or be in check)
+        const int king_start = is_white ? 60 : 4;
+        if (king != king_start)
+            return;
+
+        for (int king_side = 0; king_side < 2; king_side++)
+        {
+            const int dir     = king_side ? 1 : -1;
+            const int rook_sq = king_side ? king_start + 3 : king_start - 4;
+            const uint32_t right = is_white 
+                ? (king_side ? CastlingRights::WHITE_KING : CastlingRights::WHITE_QUEEN)
+                : (king_side ? CastlingRights::BLACK_KING : CastlingRights::BLACK_QUEEN);
+
+            if (!m_castling_rights.has(right) || board[rook_sq] != Piece::createPiece(Piece::Rook, Us)
+                || (Board::in_between[king][rook_sq] & occupied))
+                continue;
+
+            bool safe = true;
+            for (int sq = king; safe && sq != king + 3 * dir; sq += dir)
+                safe = !(attackersTo(sq, occupied) & enemy);
+
+            if (safe)
+                moves.add(Move::fmove(king, king + 2 * dir, king_side ? Move::FLAG_KING_CASTLE : Move::FLAG_QUEEN_CASTLE));
+        }
+    }
+
+    /**
+     * @brief Generate the pseudo-legal moves of the side to move, the search validates
+     * them with `isLegalAfter` only when they are tried
+     * @tparam gen all moves, captures, quiets or evasions (use them when in check)
+     */
+    template <GenType gen>
+    MoveList Board::generatePseudoLegalMoves()
+    {
+        MoveList moves;
+        if (turn())
+            _gen_pseudo_legal<Piece::White, gen>(moves);
+        else
+            _gen_pseudo_legal<Piece::Black, gen>(moves);
+        return moves;
+    }
+
     /**
      * @brief Generate all the moves for the current board
+     * @tparam gen Type of the moves to generate: all, captures only 
+     * (with capture promotions) or quiets only (with quiet promotions)
      */
+    template <GenType gen>
     MoveList Board::generateLegalMoves()
+    {
+        return turn() ? _gen_legal<Piece::White, gen>() : _gen_legal<Piece::Black, gen>();
+    }
+
+    /**
+     * @brief Generate the legal moves of given side, the pawn directions, promotion ranks
+     * and castling squares are compile time constants
+     * @tparam Us side to move (Piece::White or Piece::Black)
+     */
+    template <int Us, GenType gen>
+    MoveList Board::_gen_legal()
     {
         MoveList moves;
 
-        bool is_white            = turn();
-        bool is_enemy            = !is_white;
+        constexpr bool is_white   = Us == Piece::White;
+        constexpr bool is_enemy   = !is_white;
+        constexpr int  push       = is_white ? -8 : 8;
         Bitboard occupied        = this->occupied();
         Bitboard enemy_pieces    = this->occupied(is_enemy);
         Bitboard allied_pieces   = occupied ^ enemy_pieces;
@@ -1409,7 +2066,7 @@ namespace chess
 
         // Step 1: Generate attacks for enemy pieces (to check if the king is in check)
         Bitboard bitboard;
-        (void)generateDanger();
+        (void)_gen_danger<Us>();
         
         // Reset activity
         m_activity[KNIGHT_TYPE] = 0UL;
@@ -1432,6 +2089,7 @@ namespace chess
         pinners |= pinner;
         while(pinner) pinned |= Board::in_between[pop_lsb1(pinner)][king] & allied_pieces;
 
+        m_pinned   = pinned;
         m_in_check = false;
 
         // Step 3: Generate moves for this side
@@ -1449,7 +2107,7 @@ namespace chess
 
             // If there are more than one attackers, the king is in double check, only king moves are allowed
             if (attackers & (attackers - 1))
-                return generateEvasions(m_danger);
+                return _gen_evasions<Us, gen>(m_danger);
 
             // Generate moves to block the check,
             // The things to look out for when generating moves:
@@ -1465,96 +2123,44 @@ namespace chess
             Bitboard not_pinned = ~pinned & allied_pieces;
 
             // Generate moves for bishops
-            _gen_pieces_moves_in_check<BISHOP_TYPE>(
+            _gen_pieces_moves_in_check<gen, BISHOP_TYPE>(
                 &moves, m_bitboards[is_white][BISHOP_TYPE], occupied, attackers, 
                 not_pinned, block_path, attackers_sq, bishopAttacks
             );
 
             // Generate moves for rooks
-            _gen_pieces_moves_in_check<ROOK_TYPE>(
+            _gen_pieces_moves_in_check<gen, ROOK_TYPE>(
                 &moves, m_bitboards[is_white][ROOK_TYPE], occupied, attackers, 
                 not_pinned, block_path, attackers_sq, rookAttacks
             );
 
             // Generate moves for queens
-            _gen_pieces_moves_in_check<QUEEN_TYPE>(
+            _gen_pieces_moves_in_check<gen, QUEEN_TYPE>(
                 &moves, m_bitboards[is_white][QUEEN_TYPE], occupied, attackers, 
                 not_pinned, block_path, attackers_sq, queenAttacks
             );
 
             // Generate moves for knights
-            _gen_pieces_moves_in_check<KNIGHT_TYPE>(
+            _gen_pieces_moves_in_check<gen, KNIGHT_TYPE>(
                 &moves, m_bitboards[is_white][KNIGHT_TYPE], occupied, attackers, 
                 not_pinned, block_path, attackers_sq, knightAttacks
             );
 
-            // Generate moves for pawns
-            // Enpassant is possible only if the attacker is a pawn
-            bitboard = m_bitboards[is_white][PAWN_TYPE] & not_pinned;
-            const int offset[2] = {-8, 8};
-            const int ranks[2] = {1, 6};
+            // Generate moves for pawns (set-wise), pushes may only block the check
+            m_activity[PAWN_TYPE] = _gen_pawn_moves<Us, gen>(
+                moves, m_bitboards[is_white][PAWN_TYPE] & not_pinned, occupied, block_path, attackers
+            );
 
-            while(bitboard)
+            // Enpassant is possible only if the attacker is the pawn that just moved
+            if (gen != QUIETS && m_enpassant_target && (attackers & (1ULL << (m_enpassant_target - push))))
             {
-                Square sq          = pop_lsb1(bitboard);
-                Bitboard captures  = Board::pawnAttacks[is_white][sq] & attackers;
-                Bitboard enpassant = m_enpassant_target ? Board::pawnAttacks[is_white][sq] & (1ULL << (m_enpassant_target)) : 0;
-                Square rank        = sq >> 3;
-
-                m_activity[PAWN_TYPE] |= Board::pawnAttacks[is_white][sq];
-
-                // If the enpassant is possible and the attacker is on a valid capture square, then add the move
-                if (enpassant && attackers & (1ULL << (m_enpassant_target + offset[is_white]))){
-                    moves.add(Move::fmove(sq, m_enpassant_target, Move::FLAG_ENPASSANT_CAPTURE));
-                    m_activity[PAWN_TYPE] |= m_enpassant_target;
-                }
-                // If that's a capture, add the move
-                if (captures){
-                    // Generate captures promoting moves (the pawn is on the either 2nd or 7th rank)
-                    if (rank == ranks[is_enemy]){
-                        moves.add(Move::fmove(sq, attackers_sq, Move::FLAG_ROOK_PROMOTION_CAPTURE));
-                        moves.add(Move::fmove(sq, attackers_sq, Move::FLAG_BISHOP_PROMOTION_CAPTURE));
-                        moves.add(Move::fmove(sq, attackers_sq, Move::FLAG_KNIGHT_PROMOTION_CAPTURE));
-                        moves.add(Move::fmove(sq, attackers_sq, Move::FLAG_QUEEN_PROMOTION_CAPTURE));
-                    } else {
-                        moves.add(Move::fmove(sq, attackers_sq, Move::FLAG_CAPTURE));
-                    }
-                }
-
-                // Generate normal pawn moves
-                Square   to     = Board::mailbox[Board::mailbox64[sq] + Board::pawn_move_offsets[is_white][0]];
-                Bitboard pmoves = (1ULL << to) & ~occupied;
-
-                // If the pawn push is blocked, stop here
-                if(!pmoves)
-                    continue;
-
-                if (pmoves & block_path){
-
-                    // If the pawn is on the 2nd (black) or 7th rank (white), generate promotion moves
-                    if (rank == ranks[!is_white])
-                    {
-                        moves.add(Move::fmove(sq, to, Move::FLAG_ROOK_PROMOTION));
-                        moves.add(Move::fmove(sq, to, Move::FLAG_BISHOP_PROMOTION));
-                        moves.add(Move::fmove(sq, to, Move::FLAG_KNIGHT_PROMOTION));
-                        moves.add(Move::fmove(sq, to, Move::FLAG_QUEEN_PROMOTION));
-                        continue;
-                    }      
-                    moves.add(Move::fmove(sq, to, Move::FLAG_NONE));
-                }
-
-                // If the pawn is on the 2nd (white) or 7th rank (black), generate double pawn push
-                if (rank == ranks[is_white])
-                {
-                    to = Board::mailbox[Board::mailbox64[sq] + Board::pawn_move_offsets[is_white][1]];
-                    if ((1ULL << to) & ~occupied & block_path){
-                        moves.add(Move::fmove(sq, to, Move::FLAG_DOUBLE_PAWN));
-                    }
-                }
+                bitboard = Board::pawnAttacks[is_enemy][m_enpassant_target] & m_bitboards[is_white][PAWN_TYPE] & not_pinned;
+                while (bitboard)
+                    moves.add(Move::fmove(pop_lsb1(bitboard), m_enpassant_target, Move::FLAG_ENPASSANT_CAPTURE));
             }
 
             // Generate king moves
-            moves.add(generateEvasions(m_danger));
+            moves.add(_gen_evasions<Us, gen>(m_danger));
 
             // Return the moves after generation
             return moves;
@@ -1573,21 +2179,21 @@ namespace chess
         uint64_t bmoves, captures;
 
         // Generate moves for bishops
-        _gen_sliding_moves_no_check<BISHOP_TYPE>(
+        _gen_sliding_moves_no_check<gen, BISHOP_TYPE>(
             &moves, m_bitboards[is_white][BISHOP_TYPE], 
             occupied, enemy_pieces, pinned, pinners, king,
             bishopAttacks
         );
 
         // Generate moves for rooks
-        _gen_sliding_moves_no_check<ROOK_TYPE>(
+        _gen_sliding_moves_no_check<gen, ROOK_TYPE>(
             &moves, m_bitboards[is_white][ROOK_TYPE], 
             occupied, enemy_pieces, pinned, pinners, king,
             rookAttacks
         );
 
         // Generate moves for queens
-        _gen_sliding_moves_no_check<QUEEN_TYPE>(
+        _gen_sliding_moves_no_check<gen, QUEEN_TYPE>(
             &moves, m_bitboards[is_white][QUEEN_TYPE], 
             occupied, enemy_pieces, pinned, pinners, king,
             queenAttacks
@@ -1609,149 +2215,92 @@ namespace chess
             captures = bmoves & enemy_pieces;
             bmoves &= ~occupied;
 
+            if constexpr (gen == CAPTURES) bmoves   = 0;
+            if constexpr (gen == QUIETS)   captures = 0;
+
             while(bmoves) moves.add(Move::fmove(sq, pop_lsb1(bmoves), Move::FLAG_NONE));
             while(captures) moves.add(Move::fmove(sq, pop_lsb1(captures), Move::FLAG_CAPTURE));
         }
 
-        // Generate moves for pawns
-        bitboard = m_bitboards[is_white][PAWN_TYPE];
-        const int offset[2] = {8, -8};
-        const int ranks[2] = {1, 6}; // board is inversed, so the ranks are different
+        // Generate moves for pawns, not pinned ones set-wise
+        const Bitboard pawns = m_bitboards[is_white][PAWN_TYPE];
+        m_activity[PAWN_TYPE] = _gen_pawn_moves<Us, gen>(moves, pawns & ~pinned, occupied, ~occupied, enemy_pieces);
+
+        // Pinned pawns may move only along the pin line (or capture the pinner)
+        bitboard = pawns & pinned;
         while(bitboard)
         {
-            int sq = pop_lsb1(bitboard);
-            uint64_t enpassant_target = m_enpassant_target ? 1ULL << m_enpassant_target : 0;
-            uint64_t pinline = 0;
-            captures = Board::pawnAttacks[is_white][sq] & enemy_pieces;
-            int rank = sq >> 3;
-
-            // If the piece is pinned, restrict the moves
-            if (pinned & (1ULL << sq)){
-                // Get the pinning piece & update the pin line
-                int pinner_sq = getPinner(pinners, sq, king);
-                pinline = Board::in_between[pinner_sq][king];
-                captures &= (1ULL << pinner_sq);
-                enpassant_target &= pinline;
-            }
-
-            // Generate captures promoting moves (the pawn is on the either 2nd or 7th rank)
-            m_activity[PAWN_TYPE] |= captures;
-            if (rank == ranks[is_enemy]){
-                while(captures) {
-                    int cap_sq = pop_lsb1(captures);
-                    moves.add(Move::fmove(sq, cap_sq, Move::FLAG_ROOK_PROMOTION_CAPTURE));
-                    moves.add(Move::fmove(sq, cap_sq, Move::FLAG_BISHOP_PROMOTION_CAPTURE));
-                    moves.add(Move::fmove(sq, cap_sq, Move::FLAG_KNIGHT_PROMOTION_CAPTURE));
-                    moves.add(Move::fmove(sq, cap_sq, Move::FLAG_QUEEN_PROMOTION_CAPTURE));
-                }
-            } else {
-                while(captures) moves.add(Move::fmove(sq, pop_lsb1(captures), Move::FLAG_CAPTURE));
-            }
-
-            // Enpassant is possible only if the last move was a double pawn move
-            if (enpassant_target & Board::pawnAttacks[is_white][sq]){
-                // If the enpassant is possible, we should check if the pawn is pinned
-                // Consider a board with enpassant target at d6
-                // . . . . . . . . 8
-                // . . . . . . . . 7
-                // . . . x . . . . 6
-                // R . P p . . . K 5
-                // k . . . . . . . 4
-                // . . . . . . . . 3
-                // . . . . . . . . 2
-                // . . . . . . . . 1
-                // a b c d e f g h
-                // Taking the pawn here would expose the king to the rook / queen
-                // So we should check if the pawn is pinned to the king 
-                // (now without the black pawn)
-                Bitboard occ = occupied ^ (1ULL << (m_enpassant_target - offset[is_white]));
-                Bitboard opRQ = oppRooksQueens(is_white);
-                Bitboard ppiner = xRayRookAttacks(occ, allied_pieces, king) & opRQ;
-                Bitboard ppinned = 0;
-                while(ppiner){
-                    ppinned |= Board::in_between[pop_lsb1(ppiner)][king] & allied_pieces;
-                }
-                
-                // Check again if the pawn is pinned
-                if (ppinned & (1ULL << sq)){
-                    enpassant_target &= pinline;
-                }
-                
-                // If the pawn is not pinned or it can move along the pin line, add the move
-                if (enpassant_target){
-                    moves.add(Move::fmove(sq, m_enpassant_target, Move::FLAG_ENPASSANT_CAPTURE));
-                }
-            }
-
-            // Generate normal pawn moves
-            int n = Board::mailbox[Board::mailbox64[sq] + Board::pawn_move_offsets[is_white][0]];
-            bmoves = (1ULL << n) & ~occupied;
-
-            // If the pawn push is blocked, stop here
-            if(!bmoves)
-                continue;
-
-            // Check if the pawn is pinned, if it is, restrict the moves
-            if (pinned & (1ULL << sq)){
-                bmoves &= pinline;
-            }
+            Square sq        = pop_lsb1(bitboard);
+            Square pinner_sq = getPinner(pinners, sq, king);
+            _gen_pawn_moves<Us, gen>(
+                moves, 1ULL << sq, occupied, 
+                Board::in_between[pinner_sq][king], enemy_pieces & (1ULL << pinner_sq)
+            );
+        }
 
-            // this move might not be possible (because of pin)
-            if (bmoves){
+        // Enpassant is possible only if the last move was a double pawn move
+        bitboard = m_enpassant_target && gen != QUIETS 
+            ? Board::pawnAttacks[is_enemy][m_enpassant_target] & pawns : 0;
 
-                // If the pawn is on the 2nd (black) or 7th rank (white), generate promotion moves
-                if (rank == ranks[!is_white])
-                {
-                    int to = bit_scan_forward(bmoves);
-                    moves.add(Move::fmove(sq, to, Move::FLAG_ROOK_PROMOTION));
-                    moves.add(Move::fmove(sq, to, Move::FLAG_BISHOP_PROMOTION));
-                    moves.add(Move::fmove(sq, to, Move::FLAG_KNIGHT_PROMOTION));
-                    moves.add(Move::fmove(sq, to, Move::FLAG_QUEEN_PROMOTION));
-                    continue;
-                }
-                moves.add(Move::fmove(sq, n, Move::FLAG_NONE));
+        while(bitboard)
+        {
+            Square   sq     = pop_lsb1(bitboard);
+            Bitboard target = 1ULL << m_enpassant_target;
+
+            // Pinned pawn may capture only along the pin line
+            if (pinned & (1ULL << sq))
+                target &= Board::in_between[getPinner(pinners, sq, king)][king];
+
+            // If the enpassant is possible, we should check if the pawn is pinned
+            // Consider a board with enpassant target at d6
+            // . . . . . . . . 8
+            // . . . . . . . . 7
+            // . . . x . . . . 6
+            // R . P p . . . K 5
+            // k . . . . . . . 4
+            // . . . . . . . . 3
+            // . . . . . . . . 2
+            // . . . . . . . . 1
+            // a b c d e f g h
+            // Taking the pawn here would expose the king to the rook / queen
+            // So we should check if the pawn is pinned to the king 
+            // (now without the black pawn)
+            Bitboard occ     = occupied ^ (1ULL << (m_enpassant_target - push));
+            Bitboard ppinner = xRayRookAttacks(occ, allied_pieces, king) & oppRooksQueens(is_white);
+            Bitboard ppinned = 0;
+            while(ppinner){
+                ppinned |= Board::in_between[pop_lsb1(ppinner)][king] & allied_pieces;
             }
 
-            // If the pawn is on the 2nd (white) or 7th rank (black), generate double pawn push
-            if (rank == ranks[is_white]){
-                n = Board::mailbox[Board::mailbox64[sq] + Board::pawn_move_offsets[is_white][1]];
-                bmoves = (1ULL << n) & ~occupied;
-
-                // Check if the pawn is pinned, if it is, restrict the moves
-                if (pinned & (1ULL << sq)){
-                    bmoves &= pinline;
-                }
+            // The pawn is pinned only after the capture, it can't take
+            if ((ppinned & (1ULL << sq)) && !(pinned & (1ULL << sq)))
+                target = 0;
 
-                // this move might not be possible (because of pin)
-                if (bmoves){
-                    moves.add(Move::fmove(sq, n, Move::FLAG_DOUBLE_PAWN));
-                }
-            }
+            if (target)
+                moves.add(Move::fmove(sq, m_enpassant_target, Move::FLAG_ENPASSANT_CAPTURE));
         }
 
         // Generate moves for the king
-        moves.add(generateEvasions(m_danger));
+        moves.add(_gen_evasions<Us, gen>(m_danger));
+
+        if constexpr (gen == CAPTURES)
+            return moves;
 
         // Generate castling moves, I assume that castling rights are correct
         // TODO: Fix this shit, without this line of code, castling generation doesn't work
         // in some bizzare cases and fails `PerfTest`
         verify_castling_rights();
-        const uint32_t colors[2] = { CastlingRights::BLACK, CastlingRights::WHITE };
+        constexpr uint32_t color = is_white ? CastlingRights::WHITE : CastlingRights::BLACK;
 
-        if (castlingRights().has(colors[is_white]))
+        if (castlingRights().has(color))
         {
-            bool king_side             = (castlingRights().getKing() & colors[is_white]) != 0;
-            bool queen_side            = (castlingRights().getQueen() & colors[is_white]) != 0;
-            Bitboard queen_path        = 0b00001100;
-            Bitboard king_path         = 0b01100000;
-            Bitboard queen_path_no_occ = 0b00001110;
-
-            if(is_white)
-            {
-                queen_path <<= 56;
-                king_path <<= 56;
-                queen_path_no_occ <<= 56;
-            }
+            // Paths on the back rank of this side
+            constexpr int      back_rank         = is_white ? 56 : 0;
+            constexpr Bitboard queen_path        = 0b00001100ULL << back_rank;
+            constexpr Bitboard king_path         = 0b01100000ULL << back_rank;
+            constexpr Bitboard queen_path_no_occ = 0b00001110ULL << back_rank;
+            bool king_side                       = (castlingRights().getKing() & color) != 0;
+            bool queen_side                      = (castlingRights().getQueen() & color) != 0;
 
             // King can castle safely only if the square between target position and starting position
             // aren't occupied and aren't attacked
@@ -1768,5 +2317,13 @@ namespace chess
         return moves;
     }
 
+    template MoveList Board::generateLegalMoves<ALL_MOVES>();
+    template MoveList Board::generateLegalMoves<CAPTURES>();
+    template MoveList Board::generateLegalMoves<QUIETS>();
+    template MoveList Board::generatePseudoLegalMoves<ALL_MOVES>();
+    template MoveList Board::generatePseudoLegalMoves<CAPTURES>();
+    template MoveList Board::generatePseudoLegalMoves<QUIETS>();
+    template MoveList Board::generatePseudoLegalMoves<EVASIONS>();
+
 } // namespace chess
 
@@ -4,14 +4,12 @@ namespace chess
 {
 
 /**
- * @brief Initialize the boards, search and evaluation,
- * same as `chess::init()`
+ * @brief Initialize the cpu dependent parts (PEXT and NNUE kernels),
+ * same as `chess::init()`. The lookup tables are generated at compile time
  */
 void Engine::base_init()
 {
-    Board::init_board();
-    Eval::init();
-    init_hashing();
+    NNUE::init();
     init_magics(false);
 }
 
@@ -36,20 +34,37 @@ Engine& Engine::operator=(Engine&& other)
  */
 void Engine::reset()
 {
-    m_search_cache.getTT().clear();
+    m_search_cache.getTT().clear(threads());
     m_search_cache.getHH().clear();
     m_search_cache.getKH().clear();
+
+    for (auto& cache : m_helper_caches)
+    {
+        cache.getHH().clear();
+        cache.getKH().clear();
+    }
 }
 
 /**
- * @brief Run a perft test at the specified depth
+ * @brief Run a perft test at the specified depth, the root moves
+ * are split between the search threads
  * @param depth Depth of the perft test
  * @param print Whether to print the results
  * @return Total number of nodes
  */
 uint64_t Engine::perft(int depth, bool print)
 {
-    return bench::Perft(print).run(depth, m_board.fen());
+    return bench::Perft(print, threads()).run(depth, m_board.fen());
+}
+
+/**
+ * @brief Run the perft suite, on the search threads
+ * @param depth Maximum depth of each position
+ * @return true if all node counts are correct
+ */
+bool Engine::perftSuite(int depth, bool print)
+{
+    return bench::Perft(print, threads()).suite(depth);
 }
 
 /**
@@ -58,11 +73,43 @@ uint64_t Engine::perft(int depth, bool print)
  */
 shared_data<Result>& Engine::go(const SearchOptions& options)
 {
-    m_main_thread.stop();
-    m_main_thread.start_thinking(m_board, m_search_cache, options.limits());
+    stop();
+
+    Limits limits  = options.limits();
+    limits.multipv = m_multipv;
+
+    // Helpers search until the main thread stops them, only the best line
+    Limits helper_limits         = options.limits();
+    helper_limits.nodes          = std::numeric_limits<uint64_t>::max();
+    helper_limits.time           = {};
+    helper_limits.time.infinite  = true;
+    helper_limits.multipv        = 1;
+
+    m_search_cache.getTT().new_search();
+
+    std::vector<Thread*> helpers;
+    for (size_t i = 0; i < m_helpers.size(); i++)
+    {
+        m_helper_caches[i].shareTT(m_search_cache);
+        m_helpers[i]->start_thinking(m_board, m_helper_caches[i], helper_limits);
+        helpers.push_back(m_helpers[i].get());
+    }
+
+    m_main_thread.start_thinking(m_board, m_search_cache, limits, helpers);
     return m_main_thread.get_result();
 }
 
+/**
+ * @brief Get the statistics of the last search, summed over all threads
+ */
+SearchStats Engine::stats() const
+{
+    SearchStats stats = m_main_thread.stats();
+    for (auto& th : m_helpers)
+        stats += th->stats();
+    return stats;
+}
+
 /**
  * @brief Wait for the search to finish
  */
@@ -77,6 +124,17 @@ void Engine::join()
 void Engine::stop()
 {
     m_main_thread.stop();
+    for (auto& th : m_helpers)
+        th->stop();
+}
+
+/**
+ * @brief Switch the pondering search to the normal one (with the time limits),
+ * without restarting it
+ */
+void Engine::ponderhit()
+{
+    m_main_thread.ponderhit();
 }
 
 /**
@@ -108,12 +166,67 @@ void Engine::setPosition(const Board& board)
 // UCI options
 
 /**
- * @brief Set the hash size
+ * @brief Set the hash size, the table is reallocated only if the size changed,
+ * on failure the old table is kept
  * @param hash Size of the hash table in MB
  */
 void Engine::setHashSize(size_t size)
 {
-    m_search_cache.getTT() = TTable<TEntry>(size);
+    if (std::max(size, size_t(1)) == m_search_cache.getTT().sizeMB())
+        return;
+
+    // The table is reallocated in place, the search threads can't be reading it
+    stop();
+    if (!m_search_cache.getTT().resize(size))
+        glogger.printf("info string Failed to allocate %zu MB hash, keeping %zu MB\n",
+            size, m_search_cache.getTT().sizeMB());
+}
+
+/**
+ * @brief Set the size of the pawn structure table, each search thread owns one
+ * @param size Size of a single table in MB
+ */
+void Engine::setPawnHashSize(size_t size)
+{
+    if (size == m_pawn_hash_size)
+        return;
+
+    stop();
+    m_pawn_hash_size = size;
+    m_search_cache.resizePawnTable(size);
+    for (auto& cache : m_helper_caches)
+        cache.resizePawnTable(size);
+}
+
+/**
+ * @brief Set the number of search threads, additional threads are
+ * Lazy SMP helpers sharing the transposition table
+ * @param threads Number of threads, at least 1
+ */
+void Engine::setThreads(size_t threads)
+{
+    threads = std::max(threads, size_t(1));
+    if (threads == this->threads())
+        return;
+
+    stop();
+    m_helpers.clear();
+    m_helper_caches.clear();
+    m_helper_caches.reserve(threads - 1);
+    for (size_t i = 1; i < threads; i++)
+    {
+        m_helper_caches.emplace_back(m_search_cache, m_pawn_hash_size);
+        m_helpers.push_back(std::make_unique<Thread>(i));
+    }
+}
+
+/**
+ * @brief Set the number of lines to search (MultiPV), the lines are
+ * reported best first, in `Result::lines`
+ */
+void Engine::setMultiPV(size_t lines)
+{
+    m_multipv = std::max(lines, size_t(1));
 }
 
 /**
@@ -125,4 +238,38 @@ void Engine::setLogFile(const std::string& file)
     glogger.setLogFile(file);
 }
 
+/**
+ * @brief Load the NNUE network from given file, if it fails the handcrafted evaluation is used.
+ * The file is loaded only if it changed since the last call
+ * @param file Path to the network, empty to unload it
+ */
+void Engine::setEvalFile(const std::string& file)
+{
+    if (file == m_eval_file)
+        return;
+
+    stop();
+    m_eval_file = file;
+    if (file.empty())
+    {
+        NNUE::unload();
+        return;
+    }
+
+    if (NNUE::load(file))
+        glogger.printf("info string NNUE network %s loaded (%s)\n", file.c_str(), NNUE::kernelName());
+    else
+        glogger.printf("info string Failed to load NNUE network %s, using the handcrafted evaluation\n", file.c_str());
+}
+
+/**
+ * @brief Enable or disable the NNUE evaluation (takes effect only if the network is loaded)
+ */
+void Engine::setUseNNUE(bool use)
+{
+    if (NNUE::loaded() && use != NNUE::active())
+        stop();
+    NNUE::setEnabled(use);
+}
+
 }// namespace chess
\ No newline at end of file
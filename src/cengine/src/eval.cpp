@@ -3,286 +3,6 @@
 
 namespace chess
 {
-    // Source: https://www.chessprogramming.org/Simplified_Evaluation_Function
-    // Added [0] -> middle game, [1] -> endgame tables, [6] -> type of a piece
-    const int Eval::white_piece_square_table[2][6][64] = {
-        {
-            // pawn
-            {0,  0,  0,  0,  0,  0,  0,  0,
-            50, 50, 50, 50, 50, 50, 50, 50,
-            10, 10, 20, 30, 30, 20, 10, 10,
-            5,  5, 10, 25, 25, 10,  5,  5,
-            0,  0,  0, 20, 20,  0,  0,  0,
-            5, -5,-10,  0,  0,-10, -5,  5,
-            5, 10, 10,-20,-20, 10, 10,  5,
-            0,  0,  0,  0,  0,  0,  0,  0,},
-            // knight
-            {-50,-40,-30,-30,-30,-30,-40,-50,
-            -40,-20,  0,  0,  0,  0,-20,-40,
-            -30,  0, 10, 15, 15, 10,  0,-30,
-            -30,  5, 15, 20, 20, 15,  5,-30,
-            -30,  0, 15, 20, 20, 15,  0,-30,
-            -30,  5, 10, 15, 15, 10,  5,-30,
-            -40,-20,  0,  5,  5,  0,-20,-40,
-            -50,-40,-30,-30,-30,-30,-40,-50,},
-            // king
-            {-30,-40,-40,-50,-50,-40,-40,-30,
-            -30,-40,-40,-50,-50,-40,-40,-30,
-            -30,-40,-40,-50,-50,-40,-40,-30,
-            -30,-40,-40,-50,-50,-40,-40,-30,
-            -20,-30,-30,-40,-40,-30,-30,-20,
-            -10,-20,-20,-20,-20,-20,-20,-10,
-            20, 20,  0,  0,  0,  0, 20, 20,
-            20, 30, 20,  0,  0, 10, 30, 20},
-            // bishop
-            {-20,-10,-10,-10,-10,-10,-10,-20,
-            -10,  0,  0,  0,  0,  0,  0,-10,
-            -10,  0,  5, 10, 10,  5,  0,-10,
-            -10,  5,  5, 10, 10,  5,  5,-10,
-            -10,  0, 10, 10, 10, 10,  0,-10,
-            -10, 10, 10, 10, 10, 10, 10,-10,
-            -10,  5,  0,  0,  0,  0,  5,-10,
-            -20,-10,-10,-10,-10,-10,-10,-20,},
-            // rook
-            {0,  0,  0,  0,  0,  0,  0,  0,
-            5, 10, 10, 10, 10, 10, 10,  5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            0,  0,  0,  5,  5,  0,  0,  0},
-            // queen
-            {-20,-10,-10, -5, -5,-10,-10,-20,
-            -10,  0,  0,  0,  0,  0,  0,-10,
-            -10,  0,  5,  5,  5,  5,  0,-10,
-            -5,  0,  5,  5,  5,  5,  0, -5,
-            0,  0,  5,  5,  5,  5,  0, -5,
-            -10,  5,  5,  5,  5,  5,  0,-10,
-            -10,  0,  5,  0,  0,  0,  0,-10,
-            -20,-10,-10, -5, -5,-10,-10,-20},
-        },
-
-        // endgame
-        {
-            //pawn
-            {0,  0,  0,  0,  0,  0,  0,  0,
-            50, 50, 50, 50, 50, 50, 50, 50,
-            10, 10, 20, 30, 30, 20, 10, 10,
-            5,  5, 10, 25, 25, 10,  5,  5,
-            0,  0,  0, 20, 20,  0,  0,  0,
-            5, -5,-10,  0,  0,-10, -5,  5,
-            5, 10, 10,-20,-20, 10, 10,  5,
-            0,  0,  0,  0,  0,  0,  0,  0,},
-
-            // knight
-            {-50,-40,-30,-30,-30,-30,-40,-50,
-            -40,-20,  0,  0,  0,  0,-20,-40,
-            -30,  0, 10, 15, 15, 10,  0,-30,
-            -30,  5, 15, 20, 20, 15,  5,-30,
-            -30,  0, 15, 20, 20, 15,  0,-30,
-            -30,  5, 10, 15, 15, 10,  5,-30,
-            -40,-20,  0,  5,  5,  0,-20,-40,
-            -50,-40,-30,-30,-30,-30,-40,-50},
-
-            // king
-            {-50,-40,-30,-20,-20,-30,-40,-50,
-            -30,-20,-10,  0,  0,-10,-20,-30,
-            -30,-10, 20, 30, 30, 20,-10,-30,
-            -30,-10, 30, 40, 40, 30,-10,-30,
-            -30,-10, 30, 40, 40, 30,-10,-30,
-            -30,-10, 20, 30, 30, 20,-10,-30,
-            -30,-30,  0,  0,  0,  0,-30,-30,
-            -50,-30,-30,-30,-30,-30,-30,-50},
-
-            // bishop
-            {-20,-10,-10,-10,-10,-10,-10,-20,
-            -10,  0,  0,  0,  0,  0,  0,-10,
-            -10,  0,  5, 10, 10,  5,  0,-10,
-            -10,  5,  5, 10, 10,  5,  5,-10,
-            -10,  0, 10, 10, 10, 10,  0,-10,
-            -10, 10, 10, 10, 10, 10, 10,-10,
-            -10,  5,  0,  0,  0,  0,  5,-10,
-            -20,-10,-10,-10,-10,-10,-10,-20},
-
-            // rook
-            {0,  0,  0,  0,  0,  0,  0,  0,
-            5, 10, 10, 10, 10, 10, 10,  5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            0,  0,  0,  5,  5,  0,  0,  0},
-
-            // queen
-            {-20,-10,-10, -5, -5,-10,-10,-20,
-            -10,  0,  0,  0,  0,  0,  0,-10,
-            -10,  0,  5,  5,  5,  5,  0,-10,
-             -5,  0,  5,  5,  5,  5,  0, -5,
-              0,  0,  5,  5,  5,  5,  0, -5,
-            -10,  5,  5,  5,  5,  5,  0,-10,
-            -10,  0,  5,  0,  0,  0,  0,-10,
-            -20,-10,-10, -5, -5,-10,-10,-20},
-        }
-    };
-
-    // [turn][type][sq]
-    Byte Eval::mobility_weights[2][6][64] = {
-        {},
-
-        {
-            // white
-            {
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-            }, // pawn
-            {
-                // knight
-                0,  4,  4,  2,  2,  2,  4,  0,
-                2,  3,  3,  4,  4,  3,  3,  2,
-                1,  4,  4,  4,  4,  4,  3,  1,
-                1,  3,  4,  5,  5,  4,  3,  1,
-                0,  1,  3,  4,  4,  3,  1,  0,
-                0,  1,  1,  1,  1,  1,  1,  0,
-               -1,  0,  0, -1, -1,  0,  0, -1,
-               -4, -2, -2, -2, -2, -2, -2, -4,
-            },
-            {
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-                1, 1, 1, 1, 1, 1, 1, 1,
-            }, // king
-            {
-                // bishop 
-                2,  4,  2,  2,  2,  2,  4,  2,
-                3,  4,  3,  4,  4,  3,  4,  3,
-                1,  2,  4,  4,  4,  4,  2,  1,
-                1,  3,  4,  5,  5,  4,  3,  1,
-                0,  2,  3,  5,  5,  3,  2,  0,
-                0,  1,  1,  2,  2,  1,  1,  0,
-               -1,  0,  0, -1, -1,  0,  0, -1,
-               -4, -2, -2, -2, -2, -2, -2, -4,
-            },
-            {
-                // rook (max 44)
-                0,  5,  5,  5,  5,  5,  5,  0,
-                2,  3,  3,  5,  5,  3,  3,  2,
-                1,  2,  3,  4,  4,  3,  2,  1,
-                1,  3,  4,  5,  5,  4,  3,  1,
-                0,  2,  2,  4,  4,  2,  2,  0,
-                0,  1,  2,  2,  2,  2,  1,  0,
-               -1,  0,  0,  0,  0,  0,  0, -1,
-               -1, -1, -1, -1, -1, -1, -1, -1,
-            },
-            {
-                // queen
-                2,  4,  2,  2,  2,  2,  4,  2,
-                3,  4,  3,  4,  4,  3,  4,  3,
-                1,  2,  4,  4,  4,  4,  2,  1,
-                1,  3,  4,  5,  5,  4,  3,  1,
-                0,  2,  3,  5,  5,  3,  2,  0,
-                0,  1,  1,  2,  2,  1,  1,  0,
-               -1,  0,  0, -1, -1,  0,  0, -1,
-               -4, -2, -2, -2, -2, -2, -2, -4,
-            }
-        }
-    };
-
-    // Modifiable piece values
-    // evaluate piece based on it's position, [turn][state][type][square]
-    int Eval::piece_square_table[2][2][6][64] = {0};
-
-    // 
-    Bitboard Eval::passed_pawn_masks[2][64] = {0};
-
-    // manhattan distance [from|to][to|from] (symetrical)
-    int8_t Eval::manhattan_distance[64][64] = {0};
-
-    // Hash table for pawn structure 
-    TTable<Eval::PawnEntry> Eval::pawn_table = TTable<Eval::PawnEntry>(1);
-
-    /**
-     * @brief Initialize the boards for evaluation
-     */
-    void Eval::init()
-    {
-        // Initialize the pieces tables and mobility weights
-        for (int state = 0; state < 2; state++){
-            for (int type = 0; type < 6; type++){
-                for (int j = 0; j < 64; j++){
-                    piece_square_table[1][state][type][j] = white_piece_square_table[state][type][j];
-                    piece_square_table[0][state][type][j] = white_piece_square_table[state][type][63 - j];
-                    
-                    if (state == 0)
-                    {
-                        mobility_weights[0][type][j] = mobility_weights[1][type][63 - j];
-                    }
-                    
-                }
-            }
-        }
-
-        // Initialize the passed pawn masks
-        for(int side = 0; side < 2; side++)
-        {
-            for(Square sq = 0; sq < 64; sq++)
-            {
-                int rank = sq >> 3;
-                int file = sq % 8;
-                Bitboard file_bb = 0;
-
-                // Iterate through this square and it's sides
-                for (int i = -1; i < 2; i++)
-                {
-                    // File out of board bounds
-                    if (file + i < 0 || file + i > 7)
-                        continue;
-
-                    // Get file bitboard for this square
-                    file_bb |= file_bitboards[file + i];
-
-                    // Delete all bits BELOW or equal to this rank
-                    if (side == 0)
-                        for (int r = 0; r <= rank && rank < 7; r++)
-                            file_bb &= ~(1UL << (8*r + file + i));
-                    // Delete all bits ABOVE or eqaul to this rank
-                    else 
-                        for (int r = rank; r < 8 && rank > 0; r++)
-                            file_bb &= ~(1UL << (8*r + file + i));
-                }
-
-                passed_pawn_masks[side][sq] = file_bb;
-            }
-        }
-
-        // Initalize manhattan distance
-        for (int i = 0; i < 64; i++)
-        {
-            int rank = i / 8;
-            int file = i % 8;
-
-            for (int j = 0; j < 64; j++)
-            {
-                int rank2 = j / 8;
-                int file2 = j % 8;
-
-                manhattan_distance[i][j] = abs(rank - rank2) + abs(file - file2);
-            }
-        }
-    }
-
     /**
      * @brief Evaluate pawn structure
      */
@@ -417,13 +137,6 @@ namespace chess
         }
 
         // Pawn structure
-        // Try to get hashed pawn structure (already calculated)
-        Bitboard pawn_hash = board.pawnHash();
-        if (Eval::pawn_table.contains(pawn_hash))
-        {
-            eval += Eval::pawn_table.get(pawn_hash).eval;
-        } 
-        else 
         {
             int pawn_eval = 0;
             Bitboard pawns = board.bitboards(is_white)[Piece::Pawn - 1];
@@ -466,8 +179,6 @@ namespace chess
                 }
             }
 
-            // Store the pawn hash
-            Eval::pawn_table.store({pawn_hash, pawn_eval});
             eval += pawn_eval;
         }
 
@@ -484,27 +195,96 @@ namespace chess
         return eval;
     }
 
+    /**
+     * @brief Static exchange evaluation, check if the sequence of captures on the target
+     * square of `move` (each side recapturing with its least valuable piece, x-ray 
+     * attackers included) gains at least `threshold` centipawns for the side to move.
+     * Non-capture promotions and castling are treated as neutral.
+     */
+    bool Eval::see(Board& board, Move move, int threshold)
+    {
+        if (move.isCastle() || (move.isPromotion() && !move.isCapture()))
+            return 0 >= threshold;
+
+        const Square from   = move.getFrom();
+        const Square to     = move.getTo();
+        const int    victim = move.isEnPassant() ? Piece::Pawn : Piece::getType(board[to]);
+
+        // Gain after the first capture, if it's below the threshold even when not
+        // recaptured, the exchange is losing
+        int swap = (victim ? piece_values[victim - 1] : 0) - threshold;
+        if (swap < 0)
+            return false;
+
+        // Gain if the moved piece is captured, if it's still above the threshold, we are done
+        swap = piece_values[Piece::getType(board[from]) - 1] - swap;
+        if (swap <= 0)
+            return true;
+
+        Bitboard occupied = board.occupied() ^ (1ULL << from) ^ (1ULL << to);
+        if (move.isEnPassant())
+            occupied ^= 1ULL << (to + (board.turn() ? 8 : -8));
+
+        const Bitboard bishops = board.m_bitboards[0][Board::BISHOP_TYPE] | board.m_bitboards[1][Board::BISHOP_TYPE] | board.queens();
+        const Bitboard rooks   = board.rooks() | board.queens();
+        Bitboard attackers     = board.attackersTo(to, occupied);
+        bool     stm           = board.turn();
+        bool     res           = true;
+
+        // Least valuable attacker first
+        constexpr int order[6] = {
+            Board::PAWN_TYPE, Board::KNIGHT_TYPE, Board::BISHOP_TYPE, 
+            Board::ROOK_TYPE, Board::QUEEN_TYPE, Board::KING_TYPE
+        };
+
+        while (true)
+        {
+            stm        = !stm;
+            attackers &= occupied;
+
+            Bitboard stm_attackers = attackers & board.occupied(stm);
+            if (!stm_attackers)
+                break;
+
+            res = !res;
+
+            int type = 0;
+            Bitboard bb = 0;
+            for (; type < 6; type++)
+                if ((bb = stm_attackers & board.m_bitboards[stm][order[type]]))
+                    break;
+
+            // King may capture only if the square is no longer defended
+            if (order[type] == Board::KING_TYPE)
+                return (attackers & ~board.occupied(stm)) ? !res : res;
+
+            if ((swap = piece_values[order[type]] - swap) < int(res))
+                break;
+
+            // Remove the attacker and add the x-ray attackers behind it
+            occupied ^= bb & -bb;
+            if (order[type] == Board::PAWN_TYPE || order[type] == Board::BISHOP_TYPE || order[type] == Board::QUEEN_TYPE)
+                attackers |= bishopAttacks(occupied, to) & bishops;
+            if (order[type] == Board::ROOK_TYPE || order[type] == Board::QUEEN_TYPE)
+                attackers |= rookAttacks(occupied, to) & rooks;
+        }
+
+        return res;
+    }
+
+    /**
+     * @brief Get the material balance and the middlegame/endgame factors,
+     * based on the board's accumulator
+     */
     Eval::material_factors_t Eval::get_factors(Board& board)
     {
         bool is_white   = board.getSide() == Piece::White;
         bool is_enemy   = !is_white;
+        auto& acc       = board.m_acc;
 
         material_factors_t result = {0, 0, 0};
-        
-        for(int type = Piece::Pawn - 1; type < 6; type++)
-        {
-            if (type == Piece::King - 1)
-                continue;
-            
-            // Calculate endgame factor, by adding up values of a piece * it's quantity
-            int my_count    = pop_count(board.m_bitboards[is_white][type]);
-            int enemy_count = pop_count(board.m_bitboards[is_enemy][type]);
-
-            result.middlegame_factor += (ENDGAME_FACTOR_PIECES[type] * (my_count + enemy_count));
-
-            // Update the material
-            result.material += piece_values[type] * (my_count - enemy_count);
-        }
+        result.material           = acc.material[is_white] - acc.material[is_enemy];
+        result.middlegame_factor  = acc.phase;
 
         // Clamp the value from 0 to MAX_ENDGAME_FACTOR
         result.middlegame_factor = std::min(result.middlegame_factor, MAX_ENDGAME_FACTOR);
@@ -513,12 +293,35 @@ namespace chess
         return result;
     }
 
+    /**
+     * @brief Evaluate the pawn structure, from white's perspective
+     */
+    static int eval_pawns(Board& board)
+    {
+        int pawn_eval   = 0;
+        Bitboard pawns  = board.bitboards(true)[Piece::Pawn - 1];
+        Bitboard epawns = board.bitboards(false)[Piece::Pawn - 1];
+
+        for (int i = 0; i < 8; i++){
+            Bitboard file = Eval::file_bitboards[i];
+
+            pawn_eval += eval_pawn_structure(pawns, epawns, file, true);
+            pawn_eval -= eval_pawn_structure(epawns, pawns, file, false);
+        }
+        return pawn_eval;
+    }
+
     /**
      * @brief Evaluation function for the board in centipawns
      * positive values are good current side, negative for the opposite
+     * @param pawn_table pawn structure cache of the calling thread (optional),
+     * without it the pawn structure is always evaluated from scratch
      */
-    int Eval::evaluate(Board& board)
+    int Eval::evaluate(Board& board, PawnTable* pawn_table)
     {
+        if (NNUE::active())
+            return NNUE::evaluate(board);
+
         int eval              = 0;
         bool is_white         = board.getSide() == Piece::White;
         bool is_enemy         = !is_white; // i'm not racist
@@ -527,28 +330,11 @@ namespace chess
         auto factors = get_factors(board);
         eval        += factors.material;
 
-        // Step 2: Evaluate the piece square tables
-        int square_table_eval = 0;
-        for (int type = 0; type < 6; type++)
-        {
-            uint64_t epieces = board.m_bitboards[is_enemy][type];
-            uint64_t apieces = board.m_bitboards[is_white][type];
-
-            while(epieces)
-            {
-                Square sq = pop_lsb1(epieces);
-                square_table_eval -=
-                            (factors.endgame_factor * piece_square_table[is_enemy][ENDGAME][type][sq]
-                        + factors.middlegame_factor * piece_square_table[is_enemy][MIDDLE_GAME][type][sq]); 
-            }
-            while(apieces)
-            {
-                Square sq = pop_lsb1(apieces);
-                square_table_eval +=
-                            (factors.endgame_factor * piece_square_table[is_white][ENDGAME][type][sq]
-                        + factors.middlegame_factor * piece_square_table[is_white][MIDDLE_GAME][type][sq]);
-            }
-        }
+        // Step 2: Evaluate the piece square tables, tapered by the game phase
+        auto& psq             = board.m_acc.psq;
+        int square_table_eval = 
+              factors.endgame_factor    * (psq[is_white][ENDGAME] - psq[is_enemy][ENDGAME])
+            + factors.middlegame_factor * (psq[is_white][MIDDLE_GAME] - psq[is_enemy][MIDDLE_GAME]);
         
         square_table_eval /= MAX_ENDGAME_FACTOR;
         eval += square_table_eval;
@@ -561,30 +347,24 @@ namespace chess
             eval -= 50;
         }
 
-        // Step 3: Evaluate the pawn structure
-        // Try to get hashed pawn structure (already calculated)
-        Bitboard pawn_hash = board.pawnHash();
-        if (Eval::pawn_table.contains(pawn_hash))
+        // Step 3: Evaluate the pawn structure, the cached entry is stored from white's
+        // perspective, since the pawn key doesn't depend on the side to move
+        int pawn_eval;
+        Hash pawn_hash = board.getPawnHash();
+        if (!pawn_table)
         {
-            eval += Eval::pawn_table.get(pawn_hash).eval;
+            pawn_eval = eval_pawns(board);
+        }
+        else if (pawn_table->contains(pawn_hash))
+        {
+            pawn_eval = pawn_table->get(pawn_hash).eval;
         }
         else 
         {
-            int pawn_eval = 0;
-            Bitboard pawns = board.bitboards(is_white)[Piece::Pawn - 1];
-            Bitboard epawns = board.bitboards(is_enemy)[Piece::Pawn - 1];
-
-            for (int i = 0; i < 8; i++){
-                Bitboard file = Eval::file_bitboards[i];
-
-                pawn_eval += eval_pawn_structure(pawns, epawns, file, is_white);
-                pawn_eval -= eval_pawn_structure(epawns, pawns, file, is_enemy);
-            }
-
-            // Store the pawn hash
-            Eval::pawn_table.store({pawn_hash, pawn_eval});
-            eval += pawn_eval;
+            pawn_eval = eval_pawns(board);
+            pawn_table->store({pawn_hash, pawn_eval});
         }
+        eval += is_white ? pawn_eval : -pawn_eval;
 
         // Step 4: Calculate mobility
         // Value mobility = 0;
@@ -679,7 +459,7 @@ namespace chess
 
         // // Step 3: Evaluate the pawn structure
         // // Try to get hashed pawn structure (already calculated)
-        // Bitboard pawn_hash = board.pawnHash();
+        // Bitboard pawn_hash = board.getPawnHash();
         // if (pawn_table.contains(pawn_hash)){
         //     eval += pawn_table.get(pawn_hash);
         // } else {
@@ -4,7 +4,8 @@ Log glogger = Log((global_settings.base_path / "log.txt").string());
 
 Log::Log(std::string logfile)
 {
-    m_log_enabled = true;
+    m_print_enabled = true;
+    m_log_enabled   = true;
     m_log_file    = logfile;
     m_log_stream.open(m_log_file, std::ios::out | std::ios::app);
 }
@@ -57,11 +58,11 @@ void Log::logf(const char* format, ...)
 /**
  * @brief Log transposition table information
  */
-void Log::logTTableInfo(TTable<TEntry>* ttable)
+void Log::logTTableInfo(TranspositionTable* ttable)
 {
     logf("Transposition Table Info: "
-        "Size: %lu, ",
-        ttable->getTable().size()
+        "Size: %lu, Hashfull: %d\n",
+        ttable->size(), ttable->hashfull()
     );
 }
 
@@ -99,13 +100,15 @@ void Log::logPV(chess::MoveList* pv)
 
 /**
  * @brief Print search info
+ * @param multipv index of the line (from 1) in the MultiPV mode, 0 to omit it
  */
-void Log::printInfo(int depth, int score, bool cp, uint64_t nodes, uint64_t time, chess::MoveList* pv)
+void Log::printInfo(int depth, int score, bool cp, uint64_t nodes, uint64_t time, chess::MoveList* pv, int multipv)
 {
     time = std::max(time, 1UL);
 
     std::string str = 
         "info depth " + std::to_string(depth) 
+        + (multipv > 0 ? " multipv " + std::to_string(multipv) : "")
         + " score " + (cp ? "cp " : "mate ") + std::to_string(score) 
         + " nodes " + std::to_string(nodes) 
         + " time " + std::to_string(time) 
@@ -121,9 +124,10 @@ void Log::printInfo(int depth, int score, bool cp, uint64_t nodes, uint64_t time
         }
     }
 
+    // Flush every line, the GUI reads the output through a pipe
     str += "\n";
     if (m_print_enabled)
-        std::cout << str;
+        std::cout << str << std::flush;
 
     log(str);
 }
@@ -141,7 +145,7 @@ void Log::printf(const char* str, ...)
 
     std::string s(buffer);
     if (m_print_enabled)
-        std::cout << s;
+        std::cout << s << std::flush;
         
     log(s);
 }
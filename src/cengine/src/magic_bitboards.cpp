@@ -1,5 +1,11 @@
 #include <cengine/magic_bitboards.h>
 
+#include <bit>
+
+#if CENGINE_USE_PEXT && (defined(__GNUC__) || defined(__clang__))
+    #include <cpuid.h>
+#endif
+
 namespace chess
 {
 
@@ -38,11 +44,10 @@ const int MagicBitboards::BBits[64] =
     6, 5, 5, 5, 5, 5, 5, 6,
 };
 
-// Magic bitboards for bishop and rook attacks
-Bitboard MagicBitboards::bishopAttacks[64][512];
-Bitboard MagicBitboards::rookAttacks[64][4096];
+bool MagicBitboards::usePext = false;
 
-Magic MagicBitboards::bishopMagics[64] = {
+// Precomputed magics (see `run_magics`), offsets are set by `init_offsets`
+constexpr Magic bishop_magics[64] = {
     {0x40201008040200ULL, 0x836c04c6e7ec0101ULL, 58},
     {0x402010080400ULL, 0xc17cc3fbba0a0000ULL, 59},
     {0x4020100a00ULL, 0xe85801a92203014aULL, 59},
@@ -109,7 +114,7 @@ Magic MagicBitboards::bishopMagics[64] = {
     {0x40201008040200ULL, 0x836b3000d5210200ULL, 58},
 };
 
-Magic MagicBitboards::rookMagics[64] = {
+constexpr Magic rook_magics[64] = {
     {0x101010101017eULL, 0x2080065140008120ULL, 52},
     {0x202020202027cULL, 0x4140002005445000ULL, 53},
     {0x404040404047aULL, 0x80100082200108ULL, 53},
@@ -176,6 +181,29 @@ Magic MagicBitboards::rookMagics[64] = {
     {0x7e80808080808000ULL, 0x1001000201a04081ULL, 52},
 };
 
+/**
+ * @brief Set the offsets of the squares' slices in the attack table,
+ * each square takes 2^(64 - shift) entries
+ */
+constexpr std::array<Magic, 64> init_offsets(const Magic (&magics)[64], uint32_t offset)
+{
+    std::array<Magic, 64> result = {};
+    for (int sq = 0; sq < 64; sq++)
+    {
+        result[sq]        = magics[sq];
+        result[sq].offset = offset;
+        offset           += uint32_t(1) << (64 - magics[sq].shift);
+    }
+    return result;
+}
+
+constexpr std::array<Magic, 64> MagicBitboards::bishopMagics = init_offsets(bishop_magics, 0);
+constexpr std::array<Magic, 64> MagicBitboards::rookMagics   = init_offsets(rook_magics,
+    MagicBitboards::bishopMagics[63].offset + (uint32_t(1) << (64 - MagicBitboards::bishopMagics[63].shift)));
+
+static_assert(MagicBitboards::rookMagics[63].offset + (size_t(1) << (64 - MagicBitboards::rookMagics[63].shift))
+    == MagicBitboards::ATTACK_TABLE_SIZE, "Attack table size doesn't match the magics");
+
 // Generate a random 64-bit number, has probably the biggest impact on the generation speed
 // If you want to generate the same magics every time, you can seed the generator
 uint64_t random_uint64()
@@ -194,19 +222,59 @@ uint64_t genRandom()
     return random_uint64() & random_uint64() & random_uint64();
 }
 
-uint64_t index_occupied(int index, int bit, uint64_t mask)
+constexpr uint64_t index_occupied(int index, int bit, uint64_t mask)
 {
-    int pop;
     uint64_t occ = 0;
     for (int i = 0; i < bit; i++){
-        pop = pop_lsb1(mask);
+        uint64_t lsb = mask & -mask;
+        mask ^= lsb;
         if (index & (1 << i)){
-            occ |= (1ULL << pop);
+            occ |= lsb;
         }
     }
     return occ;
 }
 
+/**
+ * @brief Fill the attack table, each square's attacks are stored at its `Magic::offset`,
+ * indexed either by the magic multiplication or PEXT (i-th bit of the PEXT index is the
+ * i-th set bit of the mask, same as in `index_occupied`)
+ */
+constexpr void fill_attacks(Table<Bitboard, MagicBitboards::ATTACK_TABLE_SIZE>& attacks, bool pext)
+{
+    for (int bishop = 1; bishop >= 0; bishop--)
+    {
+        for (int sq = 0; sq < 64; sq++)
+        {
+            const Magic& m = bishop ? MagicBitboards::bishopMagics[sq] : MagicBitboards::rookMagics[sq];
+            int bits       = std::popcount(m.mask);
+
+            for (int i = 0; i < (1 << bits); i++)
+            {
+                uint64_t occ   = index_occupied(i, bits, m.mask);
+                uint64_t index = pext ? uint64_t(i) : (occ * m.magic) >> m.shift;
+                attacks[m.offset + index] = bishop ? Mailbox::mailboxBishop(sq, occ) : Mailbox::mailboxRook(sq, occ);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Generate the attack table indexed by the magics
+ */
+constexpr Table<Bitboard, MagicBitboards::ATTACK_TABLE_SIZE> init_attacks()
+{
+    Table<Bitboard, MagicBitboards::ATTACK_TABLE_SIZE> attacks = {};
+    fill_attacks(attacks, false);
+    return attacks;
+}
+
+#if CENGINE_USE_PEXT
+constinit Table<Bitboard, MagicBitboards::ATTACK_TABLE_SIZE> MagicBitboards::attackTable = init_attacks();
+#else
+constexpr Table<Bitboard, MagicBitboards::ATTACK_TABLE_SIZE> MagicBitboards::attackTable = init_attacks();
+#endif
+
 template <bool bishop>
 void populateAttacks(int sq, int bits, uint64_t mask, uint64_t* attacks, uint64_t *occ)
 {
@@ -334,16 +402,62 @@ void run_magics()
     });
 
     // Print the results in C++ format
-    std::string piece = bishop ? "bishopMagics" : "rookMagics";
-    std::cout << "Magic MagicBitboards::" << piece << "[64] = {\n";
+    std::string piece = bishop ? "bishop_magics" : "rook_magics";
+    std::cout << "constexpr Magic " << piece << "[64] = {\n";
     for (auto &m : vmagic)
         std::cout << "\t{0x" << std::hex << m.magic.mask << "ULL, 0x" << m.magic.magic << "ULL, "<< std::dec << m.magic.shift << "},\n";
     std::cout << "};\n\n";
 }
 
+/**
+ * @brief Check if the cpu has a fast PEXT instruction, AMD cpus before Zen 3
+ * implement it in microcode (much slower than the magic multiplication)
+ */
+bool has_fast_pext()
+{
+#if CENGINE_USE_PEXT && (defined(__GNUC__) || defined(__clang__))
+    if (!__builtin_cpu_supports("bmi2"))
+        return false;
+
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    // "AuthenticAMD"
+    if (ebx == 0x68747541 && edx == 0x69746e65 && ecx == 0x444d4163)
+    {
+        __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+        unsigned int family = (eax >> 8) & 0xf;
+        if (family == 0xf)
+            family += (eax >> 20) & 0xff;
+        return family >= 0x19;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Enable or disable the PEXT attack lookup, it can be enabled only if
+ * the engine was compiled with BMI2 support. The attack table is refilled with
+ * the new indexing, so don't call it while searching
+ * @return true if the PEXT lookup is used
+ */
+bool set_pext(bool enable)
+{
+    enable = CENGINE_USE_PEXT && enable;
+#if CENGINE_USE_PEXT
+    if (enable != MagicBitboards::usePext)
+        fill_attacks(MagicBitboards::attackTable, enable);
+#endif
+    MagicBitboards::usePext = enable;
+    return MagicBitboards::usePext;
+}
+
 // Initialize the magics, if recalculate is true, run the magic generation again, the
-// results will be printed in C++ format, otherwise use the precomputed magics and just
-// set the correct order of attacks
+// results will be printed in C++ format (the attack tables are generated at compile time
+// from the precomputed ones). Then choose the PEXT lookup if the cpu has fast PEXT
 void init_magics(bool recalculate)
 {
     if (recalculate)
@@ -353,45 +467,7 @@ void init_magics(bool recalculate)
         run_magics<false>();
     }
 
-    // Use precomputed magics, find the correct order of attacks
-    uint64_t occ[4096], bishopAtt[512], rookAtt[4096];
-    for (int sq = 0; sq < 64; sq++)
-    {
-        // For the bishop
-        memset(bishopAtt, 0, sizeof(bishopAtt));
-        memset(rookAtt, 0, sizeof(rookAtt));
-        memset(occ, 0, sizeof(occ));
-        uint64_t mask = chess::Mailbox::bishopMask(sq);
-        int bits = pop_count(mask);
-        
-        // Populate the attacks
-        for(int i = 0; i < (1 << bits); i++)
-        {
-            occ[i] = index_occupied(i, bits, mask);
-            bishopAtt[i] = chess::Mailbox::mailboxBishop(sq, occ[i]);
-
-            // Set the attack in the correct order
-            auto index = (occ[i] * MagicBitboards::bishopMagics[sq].magic) >> MagicBitboards::bishopMagics[sq].shift;
-            MagicBitboards::bishopAttacks[sq][index] = bishopAtt[i];
-        }
-
-        // For the rook
-        memset(occ, 0, sizeof(occ));
-        mask = chess::Mailbox::rookMask(sq);
-        bits = pop_count(mask);
-
-        // Populate the attacks
-        for(int i = 0; i < (1 << bits); i++)
-        {
-            occ[i] = index_occupied(i, bits, mask);
-            rookAtt[i] = chess::Mailbox::mailboxRook(sq, occ[i]);
-
-            // Set the attack in the correct order
-            auto index = (occ[i] * MagicBitboards::rookMagics[sq].magic) >> MagicBitboards::rookMagics[sq].shift;
-            MagicBitboards::rookAttacks[sq][index] = rookAtt[i];
-        }
-    }
+    set_pext(has_fast_pext());
 }
 
-
 } // namespace chess
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <cengine/memory.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#if defined(__linux__)
+#   include <sys/mman.h>
+#elif defined(_WIN32)
+#   include <malloc.h>
+#endif
+
+namespace chess
+{
+
+// Round up the size to the large page size
+static size_t round_up(size_t bytes)
+{
+    return (bytes + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE * LARGE_PAGE_SIZE;
+}
+
+/**
+ * @brief Allocate zero-initialized memory, aligned to `LARGE_PAGE_SIZE`. On linux tries
+ * to use explicit huge pages (MAP_HUGETLB), then falls back to regular pages 
+ * with transparent huge pages hint (the kernel hands out zeroed pages, so 
+ * the memory is not touched here)
+ * @param bytes Size of the allocation, should be passed to `large_free` as well
+ * @return Pointer to the memory or nullptr on failure
+ */
+void* large_alloc(size_t bytes)
+{
+    bytes = round_up(bytes);
+
+#if defined(__linux__)
+    void* mem = MAP_FAILED;
+
+#   if defined(MAP_HUGETLB)
+    mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#   endif
+
+    if (mem == MAP_FAILED)
+    {
+        mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+            return nullptr;
+
+#   if defined(MADV_HUGEPAGE)
+        madvise(mem, bytes, MADV_HUGEPAGE);
+#   endif
+    }
+    return mem;
+
+#elif defined(_WIN32)
+    void* mem = _aligned_malloc(bytes, LARGE_PAGE_SIZE);
+    if (mem)
+        parallel_zero(mem, bytes, std::thread::hardware_concurrency());
+    return mem;
+#else
+    void* mem = std::aligned_alloc(LARGE_PAGE_SIZE, bytes);
+    if (mem)
+        parallel_zero(mem, bytes, std::thread::hardware_concurrency());
+    return mem;
+#endif
+}
+
+/**
+ * @brief Free memory allocated with `large_alloc`
+ */
+void large_free(void* ptr, size_t bytes)
+{
+    if (!ptr)
+        return;
+
+#if defined(__linux__)
+    munmap(ptr, round_up(bytes));
+#elif defined(_WIN32)
+    (void)bytes;
+    _aligned_free(ptr);
+#else
+    (void)bytes;
+    std::free(ptr);
+#endif
+}
+
+/**
+ * @brief Set the memory to zero, splitting the work between `threads` threads
+ */
+void parallel_zero(void* ptr, size_t bytes, size_t threads)
+{
+    threads = std::max(threads, size_t(1));
+
+    // Not worth spawning threads for small blocks
+    constexpr size_t MIN_CHUNK = 64 * 1024 * 1024;
+    threads = std::min(threads, std::max(bytes / MIN_CHUNK, size_t(1)));
+
+    const size_t chunk = (bytes + threads - 1) / threads;
+    std::vector<std::thread> workers;
+
+    for (size_t i = 1; i < threads; i++)
+    {
+        const size_t start = i * chunk;
+        if (start >= bytes)
+            break;
+        
+        workers.emplace_back([=]() {
+            std::memset(static_cast<char*>(ptr) + start, 0, std::min(chunk, bytes - start));
+        });
+    }
+
+    std::memset(ptr, 0, std::min(chunk, bytes));
+    for (auto& w : workers)
+        w.join();
+}
+
+}
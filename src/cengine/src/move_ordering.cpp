@@ -2,27 +2,277 @@
 
 namespace chess
 {
-    void MoveOrdering::sort(MoveList *ml, Move pv, Board *board, SearchCache* sc, Depth ply)
+    /**
+     * @brief Create a move picker for the main search
+     * @param tt_move hash move for this position (null-move if non-existent),
+     * validated before being yielded
+     * @param sc search cache with history and killer heuristic
+     * @param ply current distance from the `root` position
+     * @param legal already generated legal moves (optional), if set the moves
+     * are taken from this list instead of being generated
+     */
+    MovePicker::MovePicker(Board& board, SearchCache* sc, Move tt_move, Depth ply, MoveList* legal)
+        : m_board(board), m_sc(sc), m_legal(legal), m_tt_move(tt_move), m_ply(ply)
     {
-        std::vector<OrderedMove> om(ml->size());
-        Eval::material_factors_t factors = Eval::get_factors(*board);
+        m_stage        = TT_MOVE;
+        m_killer_index = 0;
+        m_cur = m_end = m_bad_end = 0;
 
-        // Set the values of each move
-        for (size_t i = 0; i < ml->size(); i++)
+        for (int i = 0; i < KillerHeuristic::MOVES_PER_PLY; i++)
+            m_killers[i] = ply < KillerHeuristic::MAX_PLY ? sc->getKH().get(ply, i) : Move(Move::nullMove);
+
+        // Generated moves are pseudo-legal, they need the pins
+        if (!m_legal)
+            m_board.updateChecks();
+
+        if (!m_tt_move || !m_board.isValid(m_tt_move))
+        {
+            m_tt_move = Move::nullMove;
+            m_stage++;
+        }
+    }
+
+    /**
+     * @brief Create a move picker for the quiescence search, yields only captures
+     */
+    MovePicker::MovePicker(Board& board, Move tt_move)
+        : m_board(board), m_sc(nullptr), m_legal(nullptr), m_tt_move(tt_move), m_ply(0)
+    {
+        m_stage        = QS_TT_MOVE;
+        m_killer_index = 0;
+        m_cur = m_end = m_bad_end = 0;
+        m_board.updateChecks();
+
+        if (!m_tt_move || !m_tt_move.isCapture() || !m_board.isValid(m_tt_move))
+        {
+            m_tt_move = Move::nullMove;
+            m_stage++;
+        }
+    }
+
+    /**
+     * @brief Fill the move list with moves of given type, either from
+     * the already generated legal moves or by generating the pseudo-legal ones
+     * (evasions if in check), those are validated when yielded
+     */
+    void MovePicker::M_generate(GenType gen)
+    {
+        MoveList moves;
+        if (m_legal)
+        {
+            for (size_t i = 0; i < m_legal->size(); i++)
+            {
+                Move m = (*m_legal)[i];
+                if (m.isCapture() == (gen == CAPTURES))
+                    moves.add(m);
+            }
+        }
+        else if (m_board.m_in_check)
         {
-            om[i].set(
-                ml->moves[i], pv, board, sc, ply, 
-                factors.endgame_factor, factors.middlegame_factor
-            );
+            for (auto m : m_board.generatePseudoLegalMoves<EVASIONS>())
+            {
+                if (Move(m).isCapture() == (gen == CAPTURES))
+                    moves.add(m);
+            }
+        }
+        else
+        {
+            moves = gen == CAPTURES ? m_board.generatePseudoLegalMoves<CAPTURES>() 
+                : m_board.generatePseudoLegalMoves<QUIETS>();
         }
 
-        // Sort the moves, based on the value
-        std::stable_sort(om.begin(), om.end(), greater);
+        m_cur = m_moves.size();
+        m_moves.add(moves);
+        m_end = m_moves.size();
+    }
 
-        // Update the ordering of the moves
-        for (size_t i = 0; i < ml->size(); i++)
+    /**
+     * @brief Score the captures, most valuable victim - least valuable attacker,
+     * capture promotions get the value of the promoted piece
+     */
+    void MovePicker::M_score_captures()
+    {
+        for (size_t i = m_cur; i < m_end; i++)
         {
-            ml->moves[i] = om[i].move;
+            Move m      = m_moves[i];
+            m_scores[i] = M_captured_value(m);
+
+            if (m.isPromotion())
+                m_scores[i] += Eval::piece_values[Piece::promotionPieces[m.getPromotionPiece()] - 1];
+        }
+    }
+
+    /**
+     * @brief Score the quiet moves, based on the promotions, piece square tables,
+     * attacked squares and history heuristic
+     */
+    void MovePicker::M_score_quiets()
+    {
+        Eval::material_factors_t factors = Eval::get_factors(m_board);
+        const bool turn = m_board.turn();
+
+        // Squares attacked by the enemy pawns (the full danger map is not needed)
+        const Bitboard pawn_attacks = m_board.pawnAttacksBy(!turn);
+
+        for (size_t i = m_cur; i < m_end; i++)
+        {
+            Move m          = m_moves[i];
+            auto from       = m.getFrom();
+            auto to         = m.getTo();
+            auto piece_type = Piece::getType(m_board[from]);
+            int  value      = 0;
+
+            if (m.isPromotion())
+                value += promotion_bias + Eval::piece_values[Piece::promotionPieces[m.getPromotionPiece()] - 1];
+
+            if (piece_type != Piece::King)
+            {
+                // Add the piece square tables
+                // (so the moves that improve the position of the piece are ordered 1st)
+                const auto& mid_sq_table = Eval::piece_square_table[turn][Eval::MIDDLE_GAME][piece_type-1];
+                const auto& end_sq_table = Eval::piece_square_table[turn][Eval::ENDGAME][piece_type-1];
+
+                value += (mid_sq_table[to] - mid_sq_table[from]) * factors.middlegame_factor
+                    + (end_sq_table[to] - end_sq_table[from]) * factors.endgame_factor;
+
+                // Check if we are moving into attacked squares
+                if (pawn_attacks & (1ULL << to))
+                    value -= 150;
+            }
+
+            value += int(std::min<uint64_t>(m_sc->getHH().get(turn, m), promotion_bias));
+            m_scores[i] = value;
+        }
+    }
+
+    /**
+     * @brief Partial selection sort, swap the best scored move
+     * from the [m_cur, m_end) range to `m_cur` and return it
+     */
+    Move MovePicker::M_select_best()
+    {
+        size_t best = m_cur;
+        for (size_t i = m_cur + 1; i < m_end; i++)
+        {
+            if (m_scores[i] > m_scores[best])
+                best = i;
+        }
+
+        std::swap(m_moves.moves[m_cur], m_moves.moves[best]);
+        std::swap(m_scores[m_cur], m_scores[best]);
+        return m_moves[m_cur++];
+    }
+
+    /**
+     * @brief Check if the move was already yielded by the hash move or killers stage
+     */
+    bool MovePicker::M_is_yielded(Move m) const
+    {
+        if (m == m_tt_move)
+            return true;
+
+        for (int i = 0; i < m_killer_index; i++)
+            if (m_killers[i] == m)
+                return true;
+
+        return false;
+    }
+
+    /**
+     * @brief Get the next move to search
+     * @return The move, or null move if there are no more moves
+     */
+    Move MovePicker::next()
+    {
+        switch (m_stage)
+        {
+        case TT_MOVE:
+        case QS_TT_MOVE:
+            m_stage++;
+            return m_tt_move;
+
+        case GEN_CAPTURES:
+        case QS_GEN_CAPTURES:
+            M_generate(CAPTURES);
+            M_score_captures();
+            m_stage++;
+            return next();
+
+        case GOOD_CAPTURES:
+            while (m_cur < m_end)
+            {
+                Move m     = M_select_best();
+                int  score = m_scores[m_cur - 1];
+
+                if (m == m_tt_move || !M_is_legal(m))
+                    continue;
+
+                // Losing capture (by static exchange evaluation), move it to 
+                // the front of the list and search it after the quiet moves
+                if (!Eval::see(m_board, m))
+                {
+                    m_moves.moves[m_bad_end]  = m;
+                    m_scores[m_bad_end++]     = score;
+                    continue;
+                }
+                return m;
+            }
+            m_stage++;
+            return next();
+
+        case KILLERS:
+            while (m_killer_index < KillerHeuristic::MOVES_PER_PLY)
+            {
+                Move killer = m_killers[m_killer_index++];
+                if (killer && killer != m_tt_move && !killer.isCapture() && m_board.isValid(killer))
+                    return killer;
+
+                // Invalid killer, don't skip it in the quiets stage
+                m_killers[m_killer_index - 1] = Move::nullMove;
+            }
+            m_stage++;
+            return next();
+
+        case GEN_QUIETS:
+            M_generate(QUIETS);
+            M_score_quiets();
+            m_stage++;
+            return next();
+
+        case QUIET_MOVES:
+            while (m_cur < m_end)
+            {
+                Move m = M_select_best();
+                if (!M_is_yielded(m) && M_is_legal(m))
+                    return m;
+            }
+            m_cur = 0;
+            m_end = m_bad_end;
+            m_stage++;
+            return next();
+
+        case BAD_CAPTURES:
+            while (m_cur < m_end)
+            {
+                Move m = m_moves[m_cur++];
+                if (m != m_tt_move)
+                    return m;
+            }
+            m_stage = DONE;
+            return Move::nullMove;
+
+        case QS_CAPTURES:
+            while (m_cur < m_end)
+            {
+                Move m = M_select_best();
+                if (m != m_tt_move && M_is_legal(m))
+                    return m;
+            }
+            m_stage = DONE;
+            return Move::nullMove;
+
+        default:
+            return Move::nullMove;
         }
     }
-}
\ No newline at end of file
+}
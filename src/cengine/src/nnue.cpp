@@ -0,0 +1,336 @@
+#include <cengine/nnue.h>
+#include <cengine/board.h>
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define CENGINE_NNUE_X86 1
+    #include <immintrin.h>
+#endif
+
+namespace chess
+{
+    namespace
+    {
+        constexpr int H = NNUE::HIDDEN;
+
+        // dst = src + sum(adds) - sum(subs), each row has `HIDDEN` values
+        using update_fn_t  = void (*)(int16_t*, const int16_t*, const int16_t* const*, int, const int16_t* const*, int);
+        // sum of crelu(us) * weights[0, H) + crelu(them) * weights[H, 2H)
+        using forward_fn_t = int32_t (*)(const int16_t*, const int16_t*, const int16_t*);
+
+        void update_scalar(int16_t* dst, const int16_t* src,
+            const int16_t* const* adds, int n_adds, const int16_t* const* subs, int n_subs)
+        {
+            int16_t values[H];
+            std::memcpy(values, src, sizeof(values));
+
+            for (int a = 0; a < n_adds; a++)
+                for (int i = 0; i < H; i++)
+                    values[i] = int16_t(values[i] + adds[a][i]);
+
+            for (int s = 0; s < n_subs; s++)
+                for (int i = 0; i < H; i++)
+                    values[i] = int16_t(values[i] - subs[s][i]);
+
+            std::memcpy(dst, values, sizeof(values));
+        }
+
+        int32_t forward_scalar(const int16_t* us, const int16_t* them, const int16_t* weights)
+        {
+            int32_t sum = 0;
+            for (int i = 0; i < H; i++)
+            {
+                sum += std::clamp<int32_t>(us[i], 0, NNUE::QA) * weights[i];
+                sum += std::clamp<int32_t>(them[i], 0, NNUE::QA) * weights[H + i];
+            }
+            return sum;
+        }
+
+#ifdef CENGINE_NNUE_X86
+        __attribute__((target("sse4.1")))
+        void update_sse41(int16_t* dst, const int16_t* src,
+            const int16_t* const* adds, int n_adds, const int16_t* const* subs, int n_subs)
+        {
+            for (int i = 0; i < H; i += 8)
+            {
+                __m128i v = _mm_load_si128((const __m128i*)(src + i));
+                for (int a = 0; a < n_adds; a++)
+                    v = _mm_add_epi16(v, _mm_load_si128((const __m128i*)(adds[a] + i)));
+                for (int s = 0; s < n_subs; s++)
+                    v = _mm_sub_epi16(v, _mm_load_si128((const __m128i*)(subs[s] + i)));
+                _mm_store_si128((__m128i*)(dst + i), v);
+            }
+        }
+
+        __attribute__((target("sse4.1")))
+        int32_t forward_sse41(const int16_t* us, const int16_t* them, const int16_t* weights)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i qa   = _mm_set1_epi16(NNUE::QA);
+            __m128i sum        = _mm_setzero_si128();
+
+            for (int i = 0; i < H; i += 8)
+            {
+                __m128i u = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i*)(us + i)), zero), qa);
+                __m128i t = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i*)(them + i)), zero), qa);
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(u, _mm_load_si128((const __m128i*)(weights + i))));
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(t, _mm_load_si128((const __m128i*)(weights + H + i))));
+            }
+
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+            return _mm_cvtsi128_si32(sum);
+        }
+
+        __attribute__((target("avx2")))
+        void update_avx2(int16_t* dst, const int16_t* src,
+            const int16_t* const* adds, int n_adds, const int16_t* const* subs, int n_subs)
+        {
+            for (int i = 0; i < H; i += 16)
+            {
+                __m256i v = _mm256_load_si256((const __m256i*)(src + i));
+                for (int a = 0; a < n_adds; a++)
+                    v = _mm256_add_epi16(v, _mm256_load_si256((const __m256i*)(adds[a] + i)));
+                for (int s = 0; s < n_subs; s++)
+                    v = _mm256_sub_epi16(v, _mm256_load_si256((const __m256i*)(subs[s] + i)));
+                _mm256_store_si256((__m256i*)(dst + i), v);
+            }
+        }
+
+        __attribute__((target("avx2")))
+        int32_t forward_avx2(const int16_t* us, const int16_t* them, const int16_t* weights)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i qa   = _mm256_set1_epi16(NNUE::QA);
+            __m256i sum        = _mm256_setzero_si256();
+
+            for (int i = 0; i < H; i += 16)
+            {
+                __m256i u = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256((const __m256i*)(us + i)), zero), qa);
+                __m256i t = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256((const __m256i*)(them + i)), zero), qa);
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(u, _mm256_load_si256((const __m256i*)(weights + i))));
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(t, _mm256_load_si256((const __m256i*)(weights + H + i))));
+            }
+
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+            return _mm_cvtsi128_si32(half);
+        }
+#endif
+
+        struct kernel_t
+        {
+            update_fn_t  update;
+            forward_fn_t forward;
+            const char*  name;
+        };
+
+        constexpr kernel_t kernels[] = {
+            {update_scalar, forward_scalar, "scalar"},
+#ifdef CENGINE_NNUE_X86
+            {update_sse41,  forward_sse41,  "sse4.1"},
+            {update_avx2,   forward_avx2,   "avx2"},
+#endif
+        };
+
+        const kernel_t* kernel = &kernels[NNUE::SCALAR];
+
+        /**
+         * @brief Check if the cpu supports given kernel
+         */
+        bool kernel_supported(NNUE::Kernel k)
+        {
+            switch (k)
+            {
+            case NNUE::SCALAR:
+                return true;
+#ifdef CENGINE_NNUE_X86
+            case NNUE::SSE41:
+                return __builtin_cpu_supports("sse4.1");
+            case NNUE::AVX2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+            }
+        }
+
+        template <typename T>
+        bool read(std::istream& is, T* data, size_t count = 1)
+        {
+            return bool(is.read(reinterpret_cast<char*>(data), sizeof(T) * count));
+        }
+    }
+
+    /**
+     * @brief Select the fastest inference kernel supported by the cpu
+     */
+    void NNUE::init()
+    {
+        for (int k = AVX2; k >= SCALAR; k--)
+            if (setKernel(Kernel(k)))
+                break;
+    }
+
+    /**
+     * @brief Use given inference kernel
+     * @return false if the kernel is not supported by this cpu (or build),
+     * in that case the current kernel is kept
+     */
+    bool NNUE::setKernel(Kernel k)
+    {
+        if (!kernel_supported(k))
+            return false;
+
+        kernel = &kernels[k];
+        return true;
+    }
+
+    /**
+     * @brief Get the name of the current inference kernel
+     */
+    const char* NNUE::kernelName()
+    {
+        return kernel->name;
+    }
+
+    /**
+     * @brief Load the network from a file (see the class description for the format),
+     * on failure the previous network is unloaded
+     * @return true if the network was loaded
+     */
+    bool NNUE::load(const std::string& file)
+    {
+        unload();
+
+        std::ifstream is(file, std::ios::binary);
+        if (!is.is_open())
+            return false;
+
+        char     magic[4];
+        uint32_t version, hidden, buckets;
+        if (!read(is, magic, 4) || std::memcmp(magic, "CENN", 4) != 0
+            || !read(is, &version) || version != VERSION
+            || !read(is, &hidden) || hidden != HIDDEN
+            || !read(is, &buckets) || buckets != N_BUCKETS)
+            return false;
+
+        auto network = std::make_unique<Network>();
+        if (!read(is, network->ft_weights, N_FEATURES * HIDDEN)
+            || !read(is, network->ft_biases, HIDDEN)
+            || !read(is, network->out_weights, 2 * HIDDEN)
+            || !read(is, &network->out_bias))
+            return false;
+
+        // Trailing data, probably a different architecture
+        if (is.peek() != std::ifstream::traits_type::eof())
+            return false;
+
+        s_network = std::move(network);
+        s_file    = file;
+        s_active  = s_enabled;
+        return true;
+    }
+
+    /**
+     * @brief Unload the network, the handcrafted evaluation is used from now on
+     */
+    void NNUE::unload()
+    {
+        s_network.reset();
+        s_file.clear();
+        s_active = false;
+    }
+
+    /**
+     * @brief Calculate the accumulator of given perspective from scratch
+     */
+    void NNUE::M_refresh(Board& board, Accumulator& acc, bool perspective)
+    {
+        const int16_t* adds[32];
+        int n_adds = 0;
+        int bucket = kingBucket(perspective, bit_scan_forward(board.m_bitboards[perspective][Board::KING_TYPE]));
+
+        for (int color = 0; color < 2; color++)
+            for (int type = 0; type < 6; type++)
+            {
+                Bitboard bb = board.m_bitboards[color][type];
+                while (bb && n_adds < 32)
+                {
+                    int index = featureIndex(perspective, bucket, color, type, unsafe_pop_lsb1(bb));
+                    adds[n_adds++] = &s_network->ft_weights[index * HIDDEN];
+                }
+            }
+
+        kernel->update(acc.values[perspective], s_network->ft_biases, adds, n_adds, nullptr, 0);
+        acc.computed[perspective] = true;
+    }
+
+    /**
+     * @brief Compute the accumulator from the parent one, by applying the feature deltas
+     * @param bucket king bucket of the perspective, the same for both accumulators
+     */
+    void NNUE::M_update(const Accumulator& prev, Accumulator& acc, bool perspective, int bucket)
+    {
+        const int16_t* adds[Accumulator::MAX_DELTAS];
+        const int16_t* subs[Accumulator::MAX_DELTAS];
+        int n_adds = 0, n_subs = 0;
+
+        for (int i = 0; i < acc.n_deltas; i++)
+        {
+            const Delta& d    = acc.deltas[i];
+            const int16_t* row = &s_network->ft_weights[featureIndex(perspective, bucket, d.is_white, d.type, d.sq) * HIDDEN];
+            if (d.add)
+                adds[n_adds++] = row;
+            else
+                subs[n_subs++] = row;
+        }
+
+        kernel->update(acc.values[perspective], prev.values[perspective], adds, n_adds, subs, n_subs);
+        acc.computed[perspective] = true;
+    }
+
+    /**
+     * @brief Evaluate the position with the network, in centipawns from the side to move,
+     * the accumulators are updated lazily from the nearest computed parent
+     * @warning The network must be loaded
+     */
+    int NNUE::evaluate(Board& board)
+    {
+        auto& stack = board.m_nnue;
+
+        // Accumulator stack is out of sync (network loaded during the game), rebuild it
+        if (stack.size() != board.m_history.size())
+            stack.assign(board.m_history.size(), Accumulator());
+
+        const int top = int(stack.size()) - 1;
+        for (int p = 0; p < 2; p++)
+        {
+            if (stack[top].computed[p])
+                continue;
+
+            // Find the nearest computed accumulator, unless the king changed its bucket
+            int i = top;
+            while (i > 0 && !stack[i].computed[p] && !stack[i].refresh[p])
+                i--;
+
+            if (!stack[i].computed[p])
+            {
+                M_refresh(board, stack[top], p);
+                continue;
+            }
+
+            int bucket = kingBucket(p, bit_scan_forward(board.m_bitboards[p][Board::KING_TYPE]));
+            for (i++; i <= top; i++)
+                M_update(stack[i - 1], stack[i], p, bucket);
+        }
+
+        const bool stm = board.turn();
+        int64_t output = kernel->forward(stack[top].values[stm], stack[top].values[!stm], s_network->out_weights);
+        return int((output + s_network->out_bias) * SCALE / (QA * QB));
+    }
+}
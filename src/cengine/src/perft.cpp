@@ -1,17 +1,78 @@
 #include <cengine/perft.h>
+#include <cengine/threads.h>
 
 
 namespace bench
 {
 
-Perft::Perft(bool print)
+// Source: https://www.chessprogramming.org/Perft_Results
+const char* perft_suite =
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400 ;D3 8902 ;D4 197281 ;D5 4865609 ;D6 119060324\n"
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ;D1 48 ;D2 2039 ;D3 97862 ;D4 4085603 ;D5 193690690\n"
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 ;D1 14 ;D2 191 ;D3 2812 ;D4 43238 ;D5 674624 ;D6 11030083 ;D7 178633661\n"
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1 ;D1 6 ;D2 264 ;D3 9467 ;D4 422333 ;D5 15833292\n"
+    "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1 ;D1 6 ;D2 264 ;D3 9467 ;D4 422333 ;D5 15833292\n"
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8 ;D1 44 ;D2 1486 ;D3 62379 ;D4 2103487 ;D5 89941194\n"
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10 ;D1 46 ;D2 2079 ;D3 89890 ;D4 3894594 ;D5 164075551\n";
+
+/**
+ * @brief Create a perft table of given size
+ * @param sizeMB size in MB, number of entries is rounded down to a power of 2
+ */
+PerftTable::PerftTable(size_t sizeMB)
 {
-    m_print = print;
+    size_t entries = std::bit_floor(std::max(sizeMB * (1 << 20) / sizeof(Entry), size_t(1)));
+    m_table        = std::make_unique<Entry[]>(entries);
+    m_mask         = entries - 1;
+}
+
+/**
+ * @brief Look up the node count of the position at given depth
+ * @return true if found, `nodes` is set in that case
+ */
+bool PerftTable::probe(chess::Hash hash, int depth, uint64_t& nodes) const
+{
+    const Entry& e = M_entry(hash, depth);
+    uint64_t data  = e.data.load(std::memory_order_relaxed);
+    uint64_t key   = e.key.load(std::memory_order_relaxed);
+
+    if ((key ^ data) != hash || int(data & 0xff) != depth)
+        return false;
+
+    nodes = data >> 8;
+    return true;
+}
+
+/**
+ * @brief Store the node count of the position at given depth (always replace)
+ */
+void PerftTable::store(chess::Hash hash, int depth, uint64_t nodes)
+{
+    Entry& e      = const_cast<Entry&>(M_entry(hash, depth));
+    uint64_t data = (nodes << 8) | uint64_t(depth & 0xff);
+    e.data.store(data, std::memory_order_relaxed);
+    e.key.store(hash ^ data, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Create a perft test
+ * @param print print the results of each run
+ * @param threads number of threads, the root moves are split between them
+ * @param hash size of the perft hash table in MB, 0 to disable it
+ */
+Perft::Perft(bool print, size_t threads, size_t hash)
+{
+    m_print     = print;
+    m_threads   = std::max(threads, size_t(1));
+    m_hash_size = hash;
 }
 
 Perft& Perft::operator=(Perft&& other)
 {
-    m_print = other.m_print;
+    m_print     = other.m_print;
+    m_threads   = other.m_threads;
+    m_hash_size = other.m_hash_size;
+    m_table     = std::move(other.m_table);
     return *this;
 }
 
@@ -27,8 +88,38 @@ uint64_t Perft::run(int depth, std::string fen)
     using namespace std::chrono;
     auto start = high_resolution_clock::now();
 
+    if (m_hash_size && !m_table)
+        m_table = std::make_unique<PerftTable>(m_hash_size);
+
     m_board.loadFen(fen.c_str());
-    uint64_t total = perft<true>(depth);
+    chess::MoveList moves = m_board.generateLegalMoves();
+    std::vector<uint64_t> counts(moves.size(), 1);
+
+    // Split the root moves between the threads, each one works on its own board copy
+    if (depth > 1)
+    {
+        ThreadPool pool(std::min(m_threads, std::max(moves.size(), size_t(1))));
+        for (size_t i = 0; i < moves.size(); i++)
+        {
+            pool.enqueue([this, i, depth, &moves, &counts]()
+            {
+                chess::Board board = m_board;
+                board.makeMove(moves[i]);
+                counts[i] = perft(board, depth - 1, m_table.get());
+            });
+        }
+
+        // Wait for all threads to finish
+        pool.stop();
+    }
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        total += counts[i];
+        if (m_print)
+            std::cout << moves[i].uci() << ": " << counts[i] << "\n";
+    }
 
     if(m_print) {
         auto total_s  = double(duration_cast<microseconds>(high_resolution_clock::now() - start).count()) / 1000000.0;
@@ -39,40 +130,109 @@ uint64_t Perft::run(int depth, std::string fen)
 }
 
 /**
- * @brief Actual perft implementation, with root flag, to print the results
+ * @brief Parse the perft suite in EPD format, each line is a FEN followed
+ * by ';D<depth> <nodes>' entries. Picks the deepest entry not exceeding `max_depth`
  */
-template <bool root>
-uint64_t Perft::perft(int depth)
+std::vector<Perft::SuiteEntry> Perft::parseSuite(const std::string& epd, int max_depth)
 {
-    chess::MoveList moves = m_board.generateLegalMoves();
+    std::vector<SuiteEntry> entries;
+    std::istringstream lines(epd);
+    std::string line;
 
-    if(depth == 1){
-        if (root && m_print) 
+    while (std::getline(lines, line))
+    {
+        size_t sep = line.find(';');
+        if (sep == std::string::npos)
+            continue;
+
+        SuiteEntry entry = {line.substr(0, line.find_last_not_of(' ', sep - 1) + 1), 0, 0};
+        std::istringstream results(line.substr(sep));
+        std::string token;
+        uint64_t nodes;
+
+        while (results >> token >> nodes)
         {
-            for(size_t i = 0; i < moves.size(); i++)
+            int depth = std::atoi(token.c_str() + 2); // skip ';D'
+            if (depth <= max_depth && depth > entry.depth)
             {
-                std::cout << moves[i].uci() << ": " << 1UL << "\n";
+                entry.depth = depth;
+                entry.nodes = nodes;
             }
-        }  
-        return (uint64_t)moves.size();
+        }
+
+        if (entry.depth > 0)
+            entries.push_back(entry);
     }
+    return entries;
+}
 
-    uint64_t nodes = 0, cnodes = 0;
-    for(size_t i = 0; i < moves.size(); i++)
+/**
+ * @brief Run the perft suite (`perft_suite`) up to given depth, prints the result of each
+ * position and the aggregate speed
+ * @return true if all node counts match the expected ones
+ */
+bool Perft::suite(int max_depth)
+{
+    using namespace std::chrono;
+
+    bool print  = m_print;
+    bool passed = true;
+    uint64_t total = 0;
+    auto start  = high_resolution_clock::now();
+
+    m_print = false;
+    for (auto& entry : parseSuite(perft_suite, max_depth))
     {
-        auto move = moves[i];
-        m_board.makeMove(move);
-        cnodes = perft<false>(depth - 1);
-        nodes += cnodes;
-        m_board.undoMove(move);
+        auto pos_start = high_resolution_clock::now();
+        uint64_t nodes = run(entry.depth, entry.fen);
+        auto pos_ms    = duration_cast<milliseconds>(high_resolution_clock::now() - pos_start).count();
 
-        if (root && m_print)
-        {
-            std::cout << move.uci() << ": " << cnodes << "\n";
-        }
+        total  += nodes;
+        passed &= nodes == entry.nodes;
+
+        if (print)
+            std::cout << (nodes == entry.nodes ? "OK  " : "FAIL") << " depth " << entry.depth
+                << " nodes " << nodes << " expected " << entry.nodes << " time " << pos_ms
+                << " fen " << entry.fen << "\n";
     }
-    
+    m_print = print;
+
+    if (print)
+    {
+        auto total_s = double(duration_cast<microseconds>(high_resolution_clock::now() - start).count()) / 1000000.0;
+        std::cout << (passed ? "Passed" : "Failed") << ", nodes: " << total << " ("
+            << std::setprecision(4) << (double(total) / total_s) / 1000000.0 << " Mnps)\n\n";
+    }
+    return passed;
+}
+
+/**
+ * @brief Actual perft implementation, bulk counts the leaves
+ * and uses the hash table (if set) for depth >= 2
+ */
+uint64_t Perft::perft(chess::Board& board, int depth, PerftTable* table)
+{
+    uint64_t nodes = 0;
+    if (depth > 1 && table && table->probe(board.getHash(), depth, nodes))
+        return nodes;
+
+    chess::MoveList moves = board.generateLegalMoves();
+    if(depth == 1)
+        return (uint64_t)moves.size();
+
+    // Copy-make, restore the position instead of undoing the moves
+    const chess::Position position = board.position();
+    for(size_t i = 0; i < moves.size(); i++)
+    {
+        board.makeMove(moves[i]);
+        nodes += perft(board, depth - 1, table);
+        board.restore(position);
+    }
+
+    if (table)
+        table->store(board.getHash(), depth, nodes);
+
     return nodes;
 }
 
-} // namespace bench
\ No newline at end of file
+} // namespace bench
@@ -3,8 +3,16 @@
 namespace chess
 {
 
-    Thread::Thread()
+    // Lazy SMP depth skipping, helper thread `i` skips the depths where
+    // ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) is odd, so that the threads 
+    // are spread over different iterations
+    static constexpr int N_SKIP_ENTRIES       = 20;
+    static constexpr int SKIP_SIZE[N_SKIP_ENTRIES]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+    static constexpr int SKIP_PHASE[N_SKIP_ENTRIES] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+    Thread::Thread(int id)
     {
+        m_id       = id;
         m_thinking = false;
     }
 
@@ -20,22 +28,29 @@ namespace chess
     {
         m_best_result  = Result{};
         m_interrupt    = Interrupt(limits);
+        m_interrupt.time_man().init(board.turn());
         m_board        = board;
+        m_board.reserve(STACK_SIZE);
         m_search_cache = &search_cache;
         m_limits       = limits;
+        m_root_value   = 0;
+        m_stats        = {};
         m_ss.clear();
         m_root_pv.clear();
+        m_root_excluded.clear();
+        m_pv_index     = 0;
     }
 
     /**
      * @brief Launch the search thread
      */
-    void Thread::start_thinking(Board& board, SearchCache& search_cache, Limits limits)
+    void Thread::start_thinking(Board& board, SearchCache& search_cache, Limits limits, std::vector<Thread*> helpers)
     {
         if (m_thinking)
             stop();
         
         setup(board, search_cache, limits);
+        m_helpers  = std::move(helpers);
         m_thinking = true;
         m_thread = std::thread(&Thread::iterative_deepening, this);
     }
@@ -49,6 +64,14 @@ namespace chess
         join();
     }
 
+    /**
+     * @brief The opponent played the pondered move, the search continues with the time limits
+     */
+    void Thread::ponderhit()
+    {
+        m_interrupt.ponderhit();
+    }
+
     /**
      * @brief Join the thread
      */
@@ -59,51 +82,93 @@ namespace chess
     }
 
     /**
-     * @brief Get the principal variation move at a certain depth of the search,
-     * based on `m_root_pv`, should be already set.
+     * @brief Check if this helper thread should skip given iteration
      */
-    Move Thread::get_pv_move(Depth& ply)
-    {        
-        // Extensions
-        if (ply >= Depth(m_root_pv.size()))
-            return Move();
+    bool Thread::skip_depth(Depth depth) const
+    {
+        if (m_id == 0)
+            return false;
+        
+        int i = (m_id - 1) % N_SKIP_ENTRIES;
+        return ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2;
+    }
 
-        return m_root_pv.moves[ply];
+    /**
+     * @brief Get the number of nodes searched by this thread and its helpers
+     */
+    uint64_t Thread::total_nodes() const
+    {
+        uint64_t nodes = m_interrupt.nodes();
+        for (auto th : m_helpers)
+            nodes += th->nodes();
+        return nodes;
     }
 
     /**
-     * @brief Get the principal variation from the transposition table
+     * @brief Choose the thread with the best result, each thread votes for its best move
+     * with weight based on the score and completed depth. Helpers should be already stopped.
      */
-    MoveList Thread::get_pv(int max_depth)
+    Thread* Thread::vote()
     {
-        int pv_depth  = 0;
-        MoveList pv   = {};
-        uint64_t hash = m_board.getHash();
+        Thread* best = this;
+        if (m_helpers.empty() || m_limits.depth != std::numeric_limits<int>::max() || m_limits.multipv > 1)
+            return best;
+
+        std::map<Move, int64_t> votes;
+        Value min_score = m_root_value;
+        for (auto th : m_helpers)
+            min_score = std::min(min_score, th->m_root_value);
+
+        auto vote_for = [&](Thread* th) {
+            if (th->m_result.depth > 0 && th->m_result.bestmove)
+                votes[th->m_result.bestmove] += int64_t(th->m_root_value - min_score + 14) * th->m_result.depth;
+        };
+
+        vote_for(this);
+        for (auto th : m_helpers)
+            vote_for(th);
 
-        // Search through the transposition table for the principal variation
-        while (m_search_cache->getTT().contains(hash))
+        for (auto th : m_helpers)
         {
-            TEntry entry = m_search_cache->getTT().get(hash);
-            if (!entry.bestMove || pv.size() >= pv.capacity() - 1 || pv_depth++ > max_depth)
-                break;
+            if (th->m_result.depth == 0 || !th->m_result.bestmove)
+                continue;
             
-            // Add the move to the PV & make the move
-            pv.add(entry.bestMove);
-            m_board.makeMove(entry.bestMove);
-            hash = m_board.getHash();
+            if (votes[th->m_result.bestmove] > votes[best->m_result.bestmove])
+                best = th;
         }
 
-        // Unmake the moves
-        for (auto it = pv.rbegin(); it != pv.rend(); it++)
-        {
-            m_board.undoMove((*it));
-        }
+        return best;
+    }
+
+    /**
+     * @brief Prefetch the transposition table cluster (and the pawn table entry) 
+     * of the position after given move, so that the probe in the child node hits the cache
+     */
+    void Thread::prefetch(Board& board, Move move)
+    {
+        m_search_cache->getTT().prefetch(board.keyAfter(move));
+
+        Hash pawn_key = board.pawnKeyAfter(move);
+        if (pawn_key != board.getPawnHash())
+            m_search_cache->getPT().prefetch(pawn_key);
+    }
 
-        return pv;
+    /**
+     * @brief Get the principal variation move at a certain depth of the search,
+     * based on `m_root_pv`, should be already set.
+     */
+    Move Thread::get_pv_move(Depth& ply)
+    {        
+        // Extensions
+        if (ply >= Depth(m_root_pv.size()))
+            return Move();
+
+        return m_root_pv.moves[ply];
     }
 
     /**
-     * @brief Iterative deepening search
+     * @brief Iterative deepening search, the main thread waits for the helpers,
+     * votes for the best result and prints the best move
      * @warning Engine should check if the game is over before calling this function
      */
     void Thread::iterative_deepening()
@@ -111,17 +176,16 @@ namespace chess
         m_thinking = true;
 
         // Initialize variables
+        const bool is_main    = m_id == 0;
         Value eval            = 0;
-        Value alpha           = MIN;
-        Value beta            = MAX;
-        Value delta           = 50;
         m_depth               = 1;
         m_result              = {};
-        m_root_age            = m_board.halfmoveClock();
         int whotomove         = m_board.turn() ? 1 : -1;
+        Move last_best        = Move::nullMove;
 
         // Ignoring the signal, so that I will always get pv from searching
-        m_interrupt.set_ignore(); 
+        if (is_main)
+            m_interrupt.set_ignore(); 
 
         // Check if the game is over
         if (m_board.isTerminated())
@@ -129,69 +193,154 @@ namespace chess
             m_result.status  = m_board.getTermination();
             m_best_result    = m_result;
             m_thinking       = false;
-            glogger.printf("bestmove (none)\n");
+            if (is_main)
+            {
+                for (auto th : m_helpers)
+                    th->stop();
+                glogger.printf("bestmove (none)\n");
+            }
             return;
         }
 
+        // Aspiration window of each line (MultiPV)
+        struct Window
+        {
+            Value alpha = MIN;
+            Value beta  = MAX;
+            Value delta = 50;
+        };
+
+        // Line with its score from the side to move perspective
+        struct RootLine
+        {
+            Value eval;
+            Line  line;
+        };
+
+        const size_t n_lines = std::min(std::max(m_limits.multipv, size_t(1)), m_board.generateLegalMoves().size());
+        std::vector<Window> windows(n_lines);
+        std::vector<RootLine> lines;
+
         // Iterative deepening loop
         while(m_depth < MAX_PLY && !m_interrupt.get())
         {
-            // Aspiration window
-            while(true)
+            // Helpers skip some of the iterations, to diversify the search
+            if (skip_depth(m_depth))
             {
-                eval = search<Root>(m_board, alpha, beta, m_depth, 0);
+                m_depth += 1;
+                m_interrupt.depth(m_depth);
+                continue;
+            }
 
-                if (eval <= alpha)
-                {
-                    alpha = std::max(alpha - delta, MIN);
-                }
-                else if (eval >= beta)
-                {
-                    beta = std::min(beta + delta, MAX);
-                }
+            // Search the lines one by one, excluding the root moves of the lines already found,
+            // the transposition table is shared, so the next lines are much cheaper
+            lines.clear();
+            m_root_excluded.clear();
+
+            for (m_pv_index = 0; m_pv_index < n_lines; m_pv_index++)
+            {
+                Window& w = windows[m_pv_index];
+
+                // Follow the line of the previous iteration
+                if (m_pv_index < m_result.lines.size())
+                    m_root_pv = m_result.lines[m_pv_index].pv;
                 else
+                    m_root_pv.clear();
+
+                // Aspiration window
+                while(true)
                 {
-                    break;
+                    eval = search<Root>(m_board, w.alpha, w.beta, m_depth, 0);
+
+                    if (eval <= w.alpha)
+                    {
+                        w.alpha = std::max(w.alpha - w.delta, MIN);
+                    }
+                    else if (eval >= w.beta)
+                    {
+                        w.beta = std::min(w.beta + w.delta, MAX);
+                    }
+                    else
+                    {
+                        break;
+                    }
+
+                    w.delta += w.delta / 2;
                 }
 
-                delta += delta / 2;
-            }
-            
-            // eval = search<Root>(m_board, alpha, beta, m_depth);
-            if (abs(eval) >= MATE_THRESHOLD)
-                m_result.pv       = get_pv(MAX_PLY);
-            else
-                m_result.pv       = get_pv(m_depth);
-            
-            // Save the pv
-            m_root_pv         = m_result.pv;
-            m_result.bestmove = m_result.pv[0];
+                // Helper was stopped in the middle of the iteration, the result is incomplete
+                if (!is_main && m_interrupt.get())
+                    break;
 
-            // Update alpha beta
-            alpha  = eval - delta;
-            beta   = eval + delta;
+                // Update alpha beta
+                w.alpha = eval - w.delta;
+                w.beta  = eval + w.delta;
 
+                if (m_interrupt.get())
+                    break;
+
+                // Best line of this search
+                MoveList pv = m_pv.line();
+                Line line;
+                line.bestmove = pv[0];
+                line.pv       = pv;
+                update_score(line.score, eval, whotomove, pv.size());
+                lines.push_back({eval, line});
+                m_root_excluded.add(line.bestmove);
+            }
+
+            // Interrupted, the iteration is incomplete, so keep the result of the previous one
+            // (its score, lines and the printed pv match the best move)
             if (m_interrupt.get())
-            {
                 break;
-            }
+
+            // Sort the lines, best first (the later lines may fail high)
+            std::stable_sort(lines.begin(), lines.end(), 
+                [](const RootLine& a, const RootLine& b) { return a.eval > b.eval; });
 
             // Update the result object
-            update_score(m_result.score, eval, whotomove, m_result.pv.size());
-            m_result.depth = m_depth;
-            m_result.nodes = m_interrupt.nodes();
-            m_best_result = m_result;
+            eval              = lines[0].eval;
+            m_result.lines.clear();
+            for (auto& l : lines)
+                m_result.lines.push_back(l.line);
+
+            m_result.bestmove = m_result.lines[0].bestmove;
+            m_result.pv       = m_result.lines[0].pv;
+            m_result.score    = m_result.lines[0].score;
+            m_result.depth    = m_depth;
+            m_result.nodes    = is_main ? total_nodes() : nodes();
+            m_root_pv         = m_result.pv;
+            m_root_value      = eval;
+            m_best_result     = m_result;
 
-            // Print info
-            glogger.printInfo(
-                m_depth, m_result.score.value, m_result.score.type == Score::cp, 
-                m_interrupt.nodes(), m_interrupt.time(), &m_result.pv
-            );
+            // Print info, the line index only in the MultiPV mode
+            if (is_main)
+            {
+                for (size_t i = 0; i < m_result.lines.size(); i++)
+                {
+                    Line& line = m_result.lines[i];
+                    glogger.printInfo(
+                        m_depth, line.score.value, line.score.type == Score::cp, 
+                        m_result.nodes, m_interrupt.time(), &line.pv, n_lines > 1 ? int(i + 1) : 0
+                    );
+                }
+            }
 
             // Check if mate has been found
             if (m_result.score.type == Score::mate && m_depth > 3)
                 break;
 
+            // Time management, don't start the iteration that won't finish in time
+            if (is_main)
+            {
+                auto& time_man = m_interrupt.time_man();
+                time_man.iteration(m_depth > 1 && m_result.bestmove != last_best, eval);
+                last_best = m_result.bestmove;
+
+                if (!m_interrupt.pondering() && time_man.stop_iterating())
+                    break;
+            }
+
             // Update the interrupt ignore flag
             if (m_interrupt.is_ignoring())
                 m_interrupt.restore_state(m_depth);
@@ -201,6 +350,31 @@ namespace chess
             m_interrupt.depth(m_depth);
         }
 
+        if (!is_main)
+        {
+            m_thinking = false;
+            return;
+        }
+
+        // The best move can't be printed while pondering, wait for `ponderhit` or `stop`
+        while (m_interrupt.pondering() && !m_interrupt.stopped())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        // Stop the helpers and pick the best result
+        for (auto th : m_helpers)
+            th->stop();
+        
+        Thread* best = vote();
+        if (best != this)
+        {
+            m_result = best->m_result;
+            glogger.printInfo(
+                m_result.depth, m_result.score.value, m_result.score.type == Score::cp, 
+                total_nodes(), m_interrupt.time(), &m_result.pv
+            );
+        }
+        m_result.nodes = total_nodes();
+        m_best_result  = m_result;
 
         if (m_depth > MAX_PLY)
         {
@@ -208,8 +382,11 @@ namespace chess
             glogger.logf("position %s\n", m_board.fen().c_str());
         }
 
-        // Print the best move
-        glogger.printf("bestmove %s\n", m_result.bestmove.uci().c_str());
+        // Print the best move, with the expected reply to ponder on
+        if (m_result.pv.size() > 1)
+            glogger.printf("bestmove %s ponder %s\n", m_result.bestmove.uci().c_str(), m_result.pv[1].uci().c_str());
+        else
+            glogger.printf("bestmove %s\n", m_result.bestmove.uci().c_str());
         glogger.logBoardInfo(&m_board);
         glogger.logTTableInfo(&m_search_cache->getTT());
     
@@ -222,26 +399,41 @@ namespace chess
     Value Thread::qsearch(Board& board, Value alpha, Value beta, Depth ply = 0)
     {   
         // Evaluate the position
-        MoveList moves  = board.generateLegalCaptures(); 
-        Value     eval  = Eval::evaluate(board);
+        Value     eval  = Eval::evaluate(board, &m_search_cache->getPT());
 
         // Alpha beta pruning, if the evaluation is greater or equal to beta
         // that means the position is 'too good' for the side to move
         if (eval >= beta)
             return beta;
 
+        // Out of the position stack, shouldn't happen (captures only)
+        if (ply >= STACK_SIZE)
+            return std::max(alpha, eval);
+
         // Update alpha & get the legal captures
         alpha = std::max(alpha, eval);
 
-        // Loop through all the captures and evaluate them
-        for (size_t i = 0; i < moves.size(); i++)
+        // Loop through all the captures and evaluate them,
+        // captures are generated only if there was no cutoff
+        MovePicker picker(board);
+        const Position& position = m_positions[ply] = board.position();
+        Move m;
+
+        while ((m = picker.next()))
         {
+            // Skip the captures losing material, they are very unlikely to raise alpha
+            if (!Eval::see(board, m))
+                continue;
+
             m_interrupt.update();
-            Move m = moves[i];
+
+            Hash pawn_key = board.pawnKeyAfter(m);
+            if (pawn_key != board.getPawnHash())
+                m_search_cache->getPT().prefetch(pawn_key);
 
             board.makeMove(m);
             eval = -qsearch(board, -beta, -alpha, ply + 1);
-            board.undoMove(m);
+            board.restore(position);
 
             if (alpha >= beta)
                 return beta;
@@ -261,45 +453,57 @@ namespace chess
     {
         constexpr bool isRoot       = nType == Root;
         constexpr NodeType nextType = isRoot ? PV : nType;
-        // constexpr bool isPv         = isRoot || nextType == PV;
+        constexpr bool isPv         = isRoot || nextType == PV;
 
         bool null_window = beta == alpha + 1;
 
-        // Update interrupt
+        // Update interrupt, clear the line of this node
         m_interrupt.update();
+        m_pv.clear(ply);
         
-        // Step 1: Check if this node is terminated
-        // Generate legal moves, setup variables for the search
-        MoveList moves  = board.generateLegalMoves();
-        Value best      = MATE - depth;
+        // Step 1: Check for draws, without generating the moves
+        // Repetition, a single one inside the search tree is enough
+        if (!isRoot && board.isRepetition(ply))
+            return 0;
+
+        // Fifty move rule (unless that's a checkmate) and insufficient material
+        if (!isRoot && ((board.halfmoveClock() >= 100 && !(board.checkers() && board.generateLegalMoves().empty()))
+            || board.isInsufficientMaterial()))
+            return 0;
 
-        // Look for draw conditions and check if the game is over
-        if (board.isTerminated(&moves))
+        // The side to move can repeat a position from the tree, so it can force at least a draw
+        if (!isRoot && alpha < 0 && board.hasUpcomingRepetition(ply))
         {
-            auto termination = board.getTermination();
-            if (termination != Termination::CHECKMATE)
-                best = 0;
-            return best;
+            alpha = 0;
+            if (alpha >= beta)
+                return alpha;
         }
 
+        Value best = MATE - depth;
+
         // Step 2:
         // Lookup transposition table and check for possible cutoffs
         Move hash_move = Move::nullMove;
         uint64_t  hash = board.getHash();
         int  old_alpha = alpha;
         
-        if (m_search_cache->getTT().contains(hash))
+        TEntry entry;
+
+        m_stats.tt_probes++;
+        
+        if (m_search_cache->getTT().probe(hash, entry))
         {
-            TEntry entry = m_search_cache->getTT().get(hash);
             hash_move    = entry.bestMove;
-            if (entry.depth >= depth)
+
+            // No cutoffs in the PV nodes, so that the lines are complete
+            if (!isPv && entry.depth >= depth)
             {
-                if (entry.nodeType == TEntry::EXACT)
+                if (entry.nodeType() == TEntry::EXACT)
                     return entry.score;
-                if (entry.nodeType == TEntry::LOWERBOUND)
-                    alpha = std::max(alpha, entry.score);
-                if (entry.nodeType == TEntry::UPPERBOUND)
-                    beta = std::min(beta, entry.score);
+                if (entry.nodeType() == TEntry::LOWERBOUND)
+                    alpha = std::max(alpha, Value(entry.score));
+                if (entry.nodeType() == TEntry::UPPERBOUND)
+                    beta = std::min(beta, Value(entry.score));
 
                 if (alpha >= beta)
                     return entry.score;
@@ -310,19 +514,20 @@ namespace chess
         if (m_interrupt.get())
             return 0;
 
-        // Step 2a: Check extensions
+        // Step 2a: Check extensions, the moves are not generated yet, so set the flag here
+        board.m_in_check = board.checkers() != 0;
         if (board.m_in_check)
             depth++;
 
         // Step 3: If depth reaches 0, do non-quiet move search
-        // Quiescence search
-        if (depth <= 0)
+        // Quiescence search (also if the search is too deep, with check extensions)
+        if (depth <= 0 || ply >= MAX_PLY)
             return qsearch(board, alpha, beta, ply);
         
         Move  bestmove            = Move::nullMove;        
         // bool improving            = m_ss.improving(board, ply);
         // bool in_check             = board.m_in_check;
-        auto static_eval          = Eval::evaluate(board);
+        auto static_eval          = Eval::evaluate(board, &m_search_cache->getPT());
         m_ss.get(ply).static_eval = static_eval;
 
         // Step 4 (NMP if in null window)
@@ -342,16 +547,26 @@ namespace chess
         // }
 
         // Step 5:
-        // Sort the moves using move ordering
-        MoveOrdering::sort(&moves, get_pv_move(ply), &board, m_search_cache, ply);
+        // Pick the moves in order: pv / hash move, captures, killers, quiets,
+        // the moves are generated lazily by the picker (not at all on a hash move cutoff)
+        Move pv_move = get_pv_move(ply);
+        MovePicker picker(board, m_search_cache, pv_move ? pv_move : hash_move, ply);
+        const Position& position = m_positions[ply] = board.position();
 
         // Step 6:
         // Loop through the rest of the moves
-        for (size_t i = 0; i < moves.size(); i++)
+        Move m;
+        size_t n_moves = 0;
+        while ((m = picker.next()))
         {
-            Move m = moves[i];
+            // Skip the root moves of the lines already found (MultiPV)
+            if (isRoot && m_root_excluded.contains(m))
+                continue;
+
+            const size_t i = n_moves++;
             Value eval = best;
 
+            prefetch(board, m);
             board.makeMove(m);
     
             // Step 6a:
@@ -382,13 +597,17 @@ namespace chess
                 eval = -search<nextType>(board, -beta, -alpha, depth - 1, ply + 1);
             }
 
-            board.undoMove(m);
+            board.restore(position);
 
             if (m_interrupt.get())
                 return 0;
 
             if (eval > best)
             {
+                // Update the line, if the move raised alpha
+                if (isPv && eval > alpha)
+                    m_pv.update(ply, m);
+
                 // Update the search best score, best move
                 best           = eval;
                 alpha          = std::max(alpha, best);
@@ -399,32 +618,34 @@ namespace chess
             }
         }
 
+        // Step 6b:
+        // No legal moves, that's either a checkmate or a stalemate
+        if (n_moves == 0)
+            return board.m_in_check ? best : 0;
+
         // Step 7:
         // Store the best move in the transposition table
-        TEntry entry;
-        entry.hash      = hash;
-        entry.depth     = depth;
-        entry.score     = best;
-        entry.bestMove  = bestmove;
-        entry.age       = m_root_age;
+        int node_type = TEntry::EXACT;
 
         if (best <= old_alpha)
-            entry.nodeType = TEntry::UPPERBOUND;
+            node_type = TEntry::UPPERBOUND;
         else if (best >= beta)
         {
-            entry.nodeType = TEntry::LOWERBOUND;
+            node_type = TEntry::LOWERBOUND;
             
             // Beta-cutoff, add that to the history and update killers
-            if (bestmove.isQuiet())
+            if (!bestmove.isCapture())
             {
                 m_search_cache->getHH().update(board.turn(), bestmove, depth);
                 m_search_cache->getKH().update(bestmove, ply);
             }
         }
-        else
-            entry.nodeType = TEntry::EXACT;
         
-        m_search_cache->getTT().store(entry);
+        // Keep the root entry of the best line (MultiPV)
+        if (isRoot && m_pv_index > 0)
+            return best;
+
+        m_search_cache->getTT().store(hash, depth, best, node_type, bestmove, static_eval);
 
         return best;
     }
@@ -0,0 +1,74 @@
+#include <cengine/transp_table.h>
+
+#include <new>
+
+/**
+ * @brief Create the table with given size in MB
+ * @throws std::bad_alloc if the table couldn't be allocated
+ */
+TranspositionTable::TranspositionTable(size_t sizeMB)
+{
+    m_clusters   = nullptr;
+    m_count      = 0;
+    m_size_mb    = 0;
+    m_generation = 0;
+    if (!resize(sizeMB))
+        throw std::bad_alloc();
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    chess::large_free(m_clusters, bytes());
+}
+
+/**
+ * @brief Resize the table, all entries are cleared. Does nothing if the size didn't change
+ * @param sizeMB New size of the table in MB
+ * @return false if the new table couldn't be allocated, the old one is kept in that case
+ */
+bool TranspositionTable::resize(size_t sizeMB)
+{
+    sizeMB = std::max(sizeMB, size_t(1));
+    if (sizeMB == m_size_mb)
+        return true;
+
+    // Allocate the new table before freeing the old one, so that a failure leaves a usable table
+    size_t count   = sizeMB * (1ULL << 20) / sizeof(TCluster);
+    auto* clusters = static_cast<TCluster*>(chess::large_alloc(count * sizeof(TCluster)));
+    if (!clusters)
+        return false;
+
+    // Memory is already zeroed by the allocator
+    chess::large_free(m_clusters, bytes());
+    m_clusters   = clusters;
+    m_count      = count;
+    m_size_mb    = sizeMB;
+    m_generation = 0;
+    return true;
+}
+
+/**
+ * @brief Clear all entries
+ * @param threads Number of threads used to clear the table
+ */
+void TranspositionTable::clear(size_t threads)
+{
+    chess::parallel_zero(m_clusters, bytes(), threads);
+    m_generation = 0;
+}
+
+/**
+ * @brief Get the approximate usage of the table in permill, 
+ * based on entries stored by the current search
+ */
+int TranspositionTable::hashfull() const
+{
+    const size_t n = std::min(m_count, size_t(1000));
+    int used       = 0;
+
+    for (size_t i = 0; i < n; i++)
+        for (auto& e : m_clusters[i].entries)
+            used += e.nodeType() != TEntry::NONE && e.generation() == m_generation;
+
+    return used * 1000 / int(n * TCluster::N_ENTRIES);
+}
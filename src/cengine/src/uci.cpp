@@ -9,7 +9,11 @@ namespace uci
     // Help map
     std::map<std::string, const char*> help_map = {
         {"perft", 
-            "perft <depth> - Run perft test at given depth, board should be already initialized\n\n"
+            "perft [<depth> | suite [depth]]\n"
+            " - <depth>: Run perft test at given depth on the current position (same as 'go perft <depth>')\n"
+            " - suite [depth]: Run the standard perft positions, each one at the deepest known depth\n"
+            "   not exceeding 'depth' (default 4), prints the node counts and the aggregate speed\n"
+            "The root moves are split between the 'Threads' threads, results are hashed\n\n"
         },
         {"position", 
             "position [startpos|fen <fen> [moves <move1> ... <moveN>]]\n"
@@ -25,20 +29,37 @@ namespace uci
             "Another one: position fen rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8 moves d7c8q\n\n"
         },
         {"go", 
-            "go [depth <depth> | nodes <nodes> | movetime <time> | wtime <time> | btime <time> | winc <time> | binc <time> | ponder | infinite]\n"
+            "go [depth <depth> | nodes <nodes> | movetime <time> | wtime <time> | btime <time> | winc <time> | binc <time> | movestogo <moves> | ponder | infinite]\n"
             " - depth <depth>: Search to the given depth\n"
             "\tExample: go depth 5 (this run search till depth 5 is fully searched)\n"
-            " - nodes <nodes>: Search the given number of nodes (not supported yet)\n"
+            " - nodes <nodes>: Search the given number of nodes\n"
             " - movetime <time>: Search for the given time in milliseconds\n"
             "\tExample: go movetime 1000 (run search for 1 second, depth is unlimited, same as 'go movetime 1000 infinite')\n"
-            " - wtime <time>: White time in milliseconds (not supprted yet)\n"
-            " - btime <time>: Black time in milliseconds (not supprted yet)\n"
-            " - winc <time>: White increment in milliseconds (not supprted yet)\n"
-            " - binc <time>: Black increment in milliseconds (not supprted yet)\n"
-            " - ponder: Ponder the best move (not supported yet)\n"
+            " - wtime <time>: White time in milliseconds\n"
+            " - btime <time>: Black time in milliseconds\n"
+            " - winc <time>: White increment in milliseconds\n"
+            " - binc <time>: Black increment in milliseconds\n"
+            " - movestogo <moves>: Moves to the next time control (sudden death if not given)\n"
+            "\tExample: go wtime 60000 btime 60000 winc 1000 binc 1000 (the engine allocates the time for the move,\n"
+            "\tit won't start an iteration that is predicted not to finish in time)\n"
+            " - ponder: Search on the opponent's time (in the position after the expected reply),\n"
+            "\tthe time limits apply after 'ponderhit', 'bestmove' is printed only after 'ponderhit' or 'stop'\n"
             " - infinite: Search indefinitely\n"
             "\t Example: go infinite (run search indefinitely, until 'stop' command is given)\n\n"
         },
+        {"smpbench",
+            "smpbench [depth] [threads] - Run Lazy SMP time-to-depth benchmark\n"
+            " - depth: Depth of the search on each benchmark position (default 6)\n"
+            " - threads: Maximum number of threads, benchmark runs with 1, 2, 4 ... up to that number (default 'Threads' option)\n"
+            "Prints the time, nodes and the speedup compared to the single thread search\n\n"
+        },
+        {"bench",
+            "bench [depth] [hash] [threads] - Run fixed depth search on the built-in benchmark positions\n"
+            " - depth: Depth of the search on each position (default 6)\n"
+            " - hash: Size of the transposition table in MB (default 16)\n"
+            " - threads: Number of search threads (default 1), node count is deterministic only with 1 thread\n"
+            "Prints the total nodes, nodes per second and the node signature\n\n"
+        },
         {"uci", "uci - Print the UCI info\n\n"},
         {"setoption", 
             "setoption name <id> [value <x>]\n"
@@ -50,6 +71,7 @@ namespace uci
         {"debug", "debug - Toggle debug mode\n\n"},
         {"isready", "isready - Check if the engine is ready\n\n"},
         {"stop", "stop - Stop the search\n\n"},
+        {"ponderhit", "ponderhit - The opponent played the expected move, continue the pondering search with the time limits\n\n"},
         {"getfen", "getfen - Get the current FEN (unofficial)\n\n"},
         {
             "makemove",
@@ -68,9 +90,12 @@ namespace uci
             "debug\n"
             "position [startpos|fen <fen> [moves <move1> ... <moveN>]]\n"
             "makemove <move>\n"
-            "go [depth <depth> | nodes <nodes> | movetime <time> | wtime <time> | btime <time> | winc <time> | binc <time> | ponder | infinite]\n"
-            "perft <depth>\n"
+            "go [depth <depth> | nodes <nodes> | movetime <time> | wtime <time> | btime <time> | winc <time> | binc <time> | movestogo <moves> | ponder | infinite]\n"
+            "perft [<depth> | suite [depth]]\n"
+            "smpbench [depth] [threads]\n"
+            "bench [depth] [hash] [threads]\n"
             "stop\n"
+            "ponderhit\n"
             "getfen\n"
             "help\n"
             "quit\n\n"
@@ -87,12 +112,16 @@ namespace uci
         Position,
         Go,
         Stop,
+        PonderHit,
         GetFen,
         MakeMove,
         Help,
         Quit,
         Debug,
         SetOption,
+        SmpBench,
+        PerftCommand,
+        BenchCommand,
     };
 
     std::map<std::string, Commands> command_map = {
@@ -104,10 +133,14 @@ namespace uci
         {"position", Position},
         {"go", Go},
         {"stop", Stop},
+        {"ponderhit", PonderHit},
         {"getfen", GetFen},
         {"makemove", MakeMove},
         {"help", Help},
         {"quit", Quit},
+        {"smpbench", SmpBench},
+        {"perft", PerftCommand},
+        {"bench", BenchCommand},
     };
 
 
@@ -189,11 +222,12 @@ namespace uci
      * - depth <depth>: Search to the given depth
      * - nodes <nodes>: Search the given number of nodes
      * - movetime <time>: Search for the given time in milliseconds
-     * - wtime <time>: White time in milliseconds (not supprted yet)
-     * - btime <time>: Black time in milliseconds (not supprted yet)
-     * - winc <time>: White increment in milliseconds (not supprted yet)
-     * - binc <time>: Black increment in milliseconds (not supprted yet)
-     * - ponder: Ponder the best move (not supported yet)
+     * - wtime <time>: White time in milliseconds
+     * - btime <time>: Black time in milliseconds
+     * - winc <time>: White increment in milliseconds
+     * - binc <time>: Black increment in milliseconds
+     * - movestogo <moves>: Moves to the next time control
+     * - ponder: Search on the opponent's time, until `ponderhit` or `stop`
      * - infinite: Search indefinitely
      * 
      * Throws `std::runtime_error` if the command is invalid
@@ -292,6 +326,10 @@ namespace uci
                 m_engine.stop();
                 break;
 
+            case PonderHit:
+                m_engine.ponderhit();
+                break;
+
             case Debug:
                 // TODO: Implement debug
                 // Toggle debug mode
@@ -333,6 +371,42 @@ namespace uci
             }
                 break;
 
+            case SmpBench: {
+                int depth   = 6;
+                int threads = m_options["Threads"].spin().value;
+                if (iss >> depth)
+                    iss >> threads;
+                bench::TimeToDepth(true).run(depth, threads, m_options["Hash"].spin().value);
+            }
+                break;
+
+            case BenchCommand: {
+                int depth      = bench::Bench::DEFAULT_DEPTH;
+                size_t hash    = chess::SearchCache::DEFAULT_HASH_SIZE;
+                size_t threads = 1;
+                if (iss >> depth && iss >> hash)
+                    iss >> threads;
+                bench::Bench(true).run(depth, hash, threads);
+            }
+                break;
+
+            case PerftCommand: {
+                std::string arg;
+                iss >> arg;
+                if (arg == "suite")
+                {
+                    int depth = 4;
+                    iss >> depth;
+                    m_engine.perftSuite(depth);
+                }
+                else
+                {
+                    std::istringstream depth(arg);
+                    m_engine.perft(readInt(depth, "(perft): Invalid depth: " + arg));
+                }
+            }
+                break;
+
             case Quit:
             default:
                 break;
@@ -412,7 +486,7 @@ namespace uci
             }
             
             // Print the output
-            std::cout << output;
+            std::cout << output << std::flush;
         });
     }
 }
\ No newline at end of file
@@ -7,6 +7,9 @@ UI_NAMESPACE_BEGIN
 class Analysis : public ChessManager
 {
 public:
+    // Number of lines shown after the search (MultiPV)
+    static constexpr size_t N_LINES = 3;
+
     Analysis() = default;
     void loop(chess::ArgParser::arg_map_t&) override;
 
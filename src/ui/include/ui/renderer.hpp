@@ -26,6 +26,7 @@ public:
     static void render_board(const chess::Board& board, bool side = 1);
     static void render_engine_line(const chess::Result& result, bool pv = false);
     static void render_engine_outputs(const chess::Result& result, bool pv = false);
+    static void render_engine_lines(const chess::Result& result);
 
     // Flush the output
     static void flush()
@@ -6,6 +6,7 @@ UI_NAMESPACE_BEGIN
 void Analysis::loop(arg_map_t& args)
 {
     M_loop_setup(args);
+    m_engine.setMultiPV(N_LINES);
 
     // Main game loop
     while(!m_engine.m_board.isTerminated()) 
@@ -61,6 +62,8 @@ void Analysis::loop(arg_map_t& args)
 
         m_result = m_engine.m_main_thread.get_result().get();
         render_engine_outputs(m_result, true);
+        if (m_result.lines.size() > 1)
+            render_engine_lines(m_result);
     }
 }
 
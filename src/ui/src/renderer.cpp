@@ -145,5 +145,23 @@ void Renderer::render_engine_outputs(const chess::Result& result, bool pv)
     flush();
 }
 
+/**
+ * @brief Render all lines of the MultiPV search (best first), each with its principal variation
+ */
+void Renderer::render_engine_lines(const chess::Result& result)
+{
+    for (auto& line : result.lines)
+    {
+        chess::Result r;
+        r.depth    = result.depth;
+        r.bestmove = line.bestmove;
+        r.score    = line.score;
+        r.pv       = line.pv;
+        render_engine_line(r, true);
+        print<false, false>('\n');
+    }
+    flush();
+}
+
 UI_NAMESPACE_END
 
@@ -110,4 +110,91 @@ TEST(Board, loadGetFen){
     EXPECT_STREQ(fen, getfen.c_str());
 }
 
+// Evaluation accumulator is updated incrementally by make/undo move,
+// should be the same as the one calculated from scratch
+TEST(Board, incrementalAccumulator)
+{
+    chess::init();
+
+    constexpr const char* FENS[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+    };
+
+    for (const auto& fen : FENS)
+    {
+        Board board(fen);
+        const Accumulator root = board.accumulator();
+        EXPECT_EQ(root, Board(board).refreshAccumulator()) << fen;
+
+        for (auto m : board.generateLegalMoves())
+        {
+            Move move(m);
+            board.makeMove(move);
+            EXPECT_EQ(board.accumulator(), Board(board).refreshAccumulator()) << fen << " " << move.uci();
+            Board fresh(board.fen());
+            EXPECT_EQ(Eval::evaluate(board), Eval::evaluate(fresh)) << fen << " " << move.uci();
+
+            for (auto r : board.generateLegalMoves())
+            {
+                board.makeMove(Move(r));
+                EXPECT_EQ(board.accumulator(), Board(board).refreshAccumulator()) << fen << " " << move.uci();
+                board.undoMove(Move(r));
+            }
+
+            board.undoMove(move);
+            EXPECT_EQ(board.accumulator(), root) << fen << " " << move.uci();
+        }
+    }
+}
+
+// Restoring the saved position gives the same board as undoing the move
+TEST(Board, restoreMatchesUndo)
+{
+    chess::init();
+
+    constexpr const char* FENS[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    for (const auto& fen : FENS)
+    {
+        Board board(fen);
+        const Position position = board.position();
+
+        for (auto m : board.generateLegalMoves())
+        {
+            Move move(m);
+            Board undone(board);
+            undone.makeMove(move);
+            undone.undoMove(move);
+
+            board.makeMove(move);
+            board.restore(position);
+
+            EXPECT_EQ(board.fen(), undone.fen()) << fen << " " << move.uci();
+            EXPECT_EQ(board.getHash(), undone.getHash()) << fen << " " << move.uci();
+            EXPECT_EQ(board.history(), undone.history()) << fen << " " << move.uci();
+            EXPECT_EQ(board.castlingRights().get(), undone.castlingRights().get()) << fen << " " << move.uci();
+        }
+    }
+}
+
+TEST(Board, undoKeepsHalfmoveClock)
+{
+    chess::init();
+
+    Board board("8/8/8/r7/8/7K/2k5/8 w - - 99 80");
+    board.makeMove(board.match(Move("h3g3")));
+    EXPECT_EQ(board.halfmoveClock(), 100);
+
+    board.undoMove(board.history().back().move);
+    EXPECT_EQ(board.halfmoveClock(), 99);
+    EXPECT_EQ(board.fullmoveCounter(), 80);
+}
+
 } // namespace
\ No newline at end of file
@@ -171,4 +171,73 @@ TEST_F(HashTest, LoseCastlingRightsRook)
     EXPECT_EQ(hash, board.hash()); // Hash should be the same
 }
 
+// Pawn hash is updated incrementally and predicted by `pawnKeyAfter`,
+// `keyAfter` predicts the hash of every move (castling and lost castling rights included)
+TEST_F(HashTest, KeyAfterMove)
+{
+    constexpr const char* FENS[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq a3 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    for (const auto& fen : FENS)
+    {
+        board.loadFen(fen);
+        MoveList moves = board.generateLegalMoves();
+
+        for (auto& m : moves)
+        {
+            Move move(m);
+            Hash key      = board.keyAfter(move);
+            Hash pawn_key = board.pawnKeyAfter(move);
+
+            board.makeMove(move);
+            EXPECT_EQ(board.getPawnHash(), pawn_key) << fen << " " << move.uci();
+            EXPECT_EQ(board.getPawnHash(), Board(board).pawnHash()) << fen << " " << move.uci();
+            EXPECT_EQ(board.getHash(), key) << fen << " " << move.uci();
+            board.undoMove(move);
+        }
+    }
+}
+
+// Keys generated at compile time are the same as the ones from std::mt19937
+TEST_F(HashTest, ZobristKeysMatchStdGenerator)
+{
+    std::mt19937 gen(0x12345678);
+    std::uniform_int_distribution<Hash> dist(0, std::numeric_limits<Hash>().max());
+
+    for (int k = 0; k < 2; k++)
+        for (int i = 0; i < 6; i++)
+            for (int j = 0; j < 64; j++)
+                ASSERT_EQ(Zobrist::hash_pieces[k][i][j], dist(gen));
+
+    for (int i = 0; i < 16; i++)
+        ASSERT_EQ(Zobrist::hash_castling[i], dist(gen));
+
+    EXPECT_EQ(Zobrist::hash_turn, dist(gen));
+
+    for (int i = 0; i < 8; i++)
+        ASSERT_EQ(Zobrist::hash_enpassant[i], dist(gen));
+}
+
+// Test the cuckoo tables contain every reversible non-pawn move
+TEST_F(HashTest, CuckooTables)
+{
+    int count = 0;
+    for (int i = 0; i < Cuckoo::SIZE; i++)
+    {
+        Hash key = Board::cuckoo.keys[i];
+        if (!key)
+            continue;
+
+        count++;
+        int from = Board::cuckoo.moves[i] & 63, to = Board::cuckoo.moves[i] >> 6;
+        EXPECT_TRUE(i == Cuckoo::h1(key) || i == Cuckoo::h2(key));
+        EXPECT_NE(from, to);
+    }
+    EXPECT_EQ(count, 3668);
+}
+
 } // namespace
\ No newline at end of file
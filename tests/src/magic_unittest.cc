@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "includes.h"
+
+#include <random>
+
+namespace
+{
+
+using namespace chess;
+
+class MagicTest: public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        chess::init();
+        m_pext = MagicBitboards::usePext;
+    }
+
+    void TearDown() override
+    {
+        set_pext(m_pext);
+    }
+
+    // Check the sliding attacks against the mailbox generation, on random occupancies
+    static void expectValidAttacks()
+    {
+        std::mt19937_64 rng(42);
+        for (int sq = 0; sq < 64; sq++)
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                Bitboard occ = rng() & rng();
+                ASSERT_EQ(bishopAttacks(occ, sq), Mailbox::mailboxBishop(sq, occ)) << "square " << sq;
+                ASSERT_EQ(rookAttacks(occ, sq), Mailbox::mailboxRook(sq, occ)) << "square " << sq;
+            }
+        }
+    }
+
+    // Check that the squares' slices are contiguous and fill the whole table
+    static void expectPacked()
+    {
+        size_t next = 0;
+        for (auto* magics : {&MagicBitboards::bishopMagics, &MagicBitboards::rookMagics})
+        {
+            for (int sq = 0; sq < 64; sq++)
+            {
+                ASSERT_EQ((*magics)[sq].offset, next) << "square " << sq;
+                next += size_t(1) << (64 - (*magics)[sq].shift);
+            }
+        }
+        EXPECT_EQ(next, MagicBitboards::ATTACK_TABLE_SIZE);
+    }
+
+    bool m_pext;
+};
+
+TEST_F(MagicTest, magicAttacks)
+{
+    set_pext(false);
+    ASSERT_FALSE(MagicBitboards::usePext);
+    expectValidAttacks();
+    expectPacked();
+}
+
+TEST_F(MagicTest, pextAttacks)
+{
+    if (!set_pext(true))
+        GTEST_SKIP() << "Compiled without BMI2 support";
+
+    expectValidAttacks();
+    expectPacked();
+}
+
+} // namespace
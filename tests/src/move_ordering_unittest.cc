@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "includes.h"
+
+#include <algorithm>
+
+namespace
+{
+
+using namespace chess;
+
+class MovePickerTest: public ::testing::Test
+{
+protected:
+    static constexpr const char* FENS[] = {
+        Board::START_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1",
+        "4k3/8/8/8/8/8/8/R3K2R w KQ - 0 1",
+        "3k4/8/8/8/8/8/8/r3K3 w - - 0 1",
+    };
+
+    void SetUp() override
+    {
+        chess::init();
+    }
+
+    // Collect all moves yielded by the picker
+    static std::vector<uint16_t> collect(MovePicker& picker)
+    {
+        std::vector<uint16_t> moves;
+        Move m;
+        while ((m = picker.next()))
+            moves.push_back(m.get());
+
+        std::sort(moves.begin(), moves.end());
+        return moves;
+    }
+
+    static std::vector<uint16_t> sorted(const MoveList& ml)
+    {
+        std::vector<uint16_t> moves(ml.data(), ml.data() + ml.size());
+        std::sort(moves.begin(), moves.end());
+        return moves;
+    }
+};
+
+TEST_F(MovePickerTest, capturesAndQuietsPartitionLegalMoves)
+{
+    for (auto fen : FENS)
+    {
+        Board board(fen);
+        MoveList all      = board.generateLegalMoves();
+        MoveList captures = board.generateLegalCaptures();
+        MoveList quiets   = board.generateLegalQuiets();
+
+        for (auto m : captures)
+            EXPECT_TRUE(Move(m).isCapture()) << "FEN: " << fen;
+        for (auto m : quiets)
+            EXPECT_FALSE(Move(m).isCapture()) << "FEN: " << fen;
+
+        captures.add(quiets);
+        EXPECT_EQ(sorted(captures), sorted(all)) << "FEN: " << fen;
+    }
+}
+
+TEST_F(MovePickerTest, isValidMatchesLegalMoves)
+{
+    for (auto fen : FENS)
+    {
+        Board board(fen);
+        auto legal = sorted(board.generateLegalMoves());
+
+        for (uint32_t m = 1; m <= 0xFFFF; m++)
+        {
+            bool expected = std::binary_search(legal.begin(), legal.end(), uint16_t(m));
+            ASSERT_EQ(board.isValid(Move(m)), expected) << "FEN: " << fen << " move: " << Move(m).uci();
+        }
+    }
+}
+
+TEST_F(MovePickerTest, yieldsEveryLegalMoveOnce)
+{
+    SearchCache cache;
+
+    for (auto fen : FENS)
+    {
+        Board board(fen);
+        MoveList legal = board.generateLegalMoves();
+        auto expected  = sorted(legal);
+
+        // Register some killers & use a quiet move as the hash move
+        Move tt_move = Move::nullMove;
+        cache.getKH().clear();
+        for (auto m : legal)
+        {
+            if (Move(m).isCapture())
+                continue;
+            if (!tt_move)
+                tt_move = m;
+            cache.getKH().update(m, 2);
+        }
+
+        MovePicker lazy(board, &cache, tt_move, 2);
+        EXPECT_EQ(collect(lazy), expected) << "FEN: " << fen;
+
+        MovePicker from_list(board, &cache, tt_move, 2, &legal);
+        EXPECT_EQ(collect(from_list), expected) << "FEN: " << fen;
+
+        // Illegal hash move should be ignored
+        MovePicker invalid_tt(board, &cache, Move(12, 44, Move::FLAG_NONE), 2);
+        EXPECT_EQ(collect(invalid_tt), expected) << "FEN: " << fen;
+
+        MovePicker qs(board);
+        EXPECT_EQ(collect(qs), sorted(board.generateLegalCaptures())) << "FEN: " << fen;
+    }
+}
+
+TEST_F(MovePickerTest, hashMoveFirstThenCaptures)
+{
+    Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    SearchCache cache;
+    Move tt_move = board.match(Move::fromUci("a2a3"));
+    ASSERT_TRUE(tt_move);
+
+    MovePicker picker(board, &cache, tt_move, 0);
+    EXPECT_EQ(picker.next(), tt_move);
+
+    // Winning capture: pawn takes a knight
+    Move first_capture = picker.next();
+    EXPECT_TRUE(first_capture.isCapture());
+    EXPECT_EQ(picker.stage(), MovePicker::GOOD_CAPTURES);
+}
+
+TEST_F(MovePickerTest, staticExchangeEvaluation)
+{
+    // Undefended pawn
+    Board board("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1");
+    Move move = board.match(Move::fromUci("e1e5"));
+    ASSERT_TRUE(move);
+    EXPECT_TRUE(Eval::see(board, move, 0));
+    EXPECT_TRUE(Eval::see(board, move, 100));
+    EXPECT_FALSE(Eval::see(board, move, 101));
+
+    // Knight takes a pawn, defended by x-ray attackers: N x P, N x N, R x N, B x R, Q x B, Q x Q
+    board.loadFen("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1");
+    move = board.match(Move::fromUci("d3e5"));
+    ASSERT_TRUE(move);
+    EXPECT_FALSE(Eval::see(board, move, 0));
+    EXPECT_TRUE(Eval::see(board, move, -220));
+    EXPECT_FALSE(Eval::see(board, move, -219));
+
+    // Quiet move into a square attacked by a pawn
+    board.loadFen("4k3/8/3p4/8/8/8/8/2R1K3 w - - 0 1");
+    move = board.match(Move::fromUci("c1c5"));
+    ASSERT_TRUE(move);
+    EXPECT_TRUE(Eval::see(board, move, -500));
+    EXPECT_FALSE(Eval::see(board, move, 0));
+
+    // Losing captures are yielded after the quiet moves
+    SearchCache cache;
+    board.loadFen("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1");
+    move = board.match(Move::fromUci("d3e5"));
+    MovePicker picker(board, &cache, Move::nullMove, 0);
+    Move m;
+    int index = 0, last_quiet = -1, losing_capture = -1;
+    while ((m = picker.next()))
+    {
+        if (!m.isCapture())
+            last_quiet = index;
+        if (m == move)
+            losing_capture = index;
+        index++;
+    }
+    EXPECT_GT(last_quiet, 0);
+    EXPECT_GT(losing_capture, last_quiet);
+}
+
+} // namespace
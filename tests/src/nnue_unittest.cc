@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "includes.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace
+{
+
+using namespace chess;
+
+class NNUETest: public ::testing::Test
+{
+protected:
+    static constexpr const char* FENS[] = {
+        Board::START_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    std::string m_file;
+
+    void SetUp() override
+    {
+        chess::init();
+        m_file = (std::filesystem::temp_directory_path() / "cengine_nnue_unittest.nnue").string();
+        writeNetwork(m_file);
+    }
+
+    void TearDown() override
+    {
+        NNUE::unload();
+        NNUE::setEnabled(true);
+        NNUE::init();
+        std::filesystem::remove(m_file);
+    }
+
+    // Write a network with random weights
+    static void writeNetwork(const std::string& file, size_t truncate = 0)
+    {
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> weight(-64, 64);
+
+        std::vector<int16_t> data(NNUE::N_FEATURES * NNUE::HIDDEN + NNUE::HIDDEN + 2 * NNUE::HIDDEN);
+        for (auto& w : data)
+            w = int16_t(weight(rng));
+
+        uint32_t header[3] = {NNUE::VERSION, NNUE::HIDDEN, NNUE::N_BUCKETS};
+        int32_t  out_bias  = 1234;
+
+        std::ofstream os(file, std::ios::binary);
+        os.write("CENN", 4);
+        os.write(reinterpret_cast<const char*>(header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(int16_t) - truncate);
+        if (!truncate)
+            os.write(reinterpret_cast<const char*>(&out_bias), sizeof(out_bias));
+    }
+
+    // Evaluate every node up to given depth, skipping every other ply
+    // (so that the accumulators are updated over multiple moves)
+    static void walk(Board& board, int depth, int ply = 0)
+    {
+        if (ply % 2 == 0 || depth == 0)
+        {
+            Board fresh(board.fen());
+            ASSERT_EQ(NNUE::evaluate(board), NNUE::evaluate(fresh)) << board.fen();
+        }
+
+        if (depth == 0)
+            return;
+
+        for (auto m : board.generateLegalMoves())
+        {
+            board.makeMove(Move(m));
+            walk(board, depth - 1, ply + 1);
+            board.undoMove(Move(m));
+        }
+    }
+};
+
+TEST_F(NNUETest, loadNetwork)
+{
+    EXPECT_FALSE(NNUE::load(m_file + ".missing"));
+    EXPECT_FALSE(NNUE::active());
+
+    writeNetwork(m_file, 2);
+    EXPECT_FALSE(NNUE::load(m_file));
+    EXPECT_FALSE(NNUE::loaded());
+
+    writeNetwork(m_file);
+    ASSERT_TRUE(NNUE::load(m_file));
+    EXPECT_TRUE(NNUE::active());
+    EXPECT_EQ(NNUE::file(), m_file);
+
+    NNUE::setEnabled(false);
+    EXPECT_TRUE(NNUE::loaded());
+    EXPECT_FALSE(NNUE::active());
+}
+
+TEST_F(NNUETest, incrementalMatchesRefresh)
+{
+    ASSERT_TRUE(NNUE::load(m_file));
+
+    for (auto fen : FENS)
+    {
+        Board board(fen);
+        int root = NNUE::evaluate(board);
+        walk(board, 3);
+        EXPECT_EQ(NNUE::evaluate(board), root) << fen;
+
+        // Null move keeps the accumulators, only the side to move changes
+        board.makeNullMove();
+        Board fresh(board.fen());
+        EXPECT_EQ(NNUE::evaluate(board), NNUE::evaluate(fresh)) << fen;
+        board.undoNullMove();
+        EXPECT_EQ(NNUE::evaluate(board), root) << fen;
+    }
+}
+
+TEST_F(NNUETest, kernelsMatchScalar)
+{
+    ASSERT_TRUE(NNUE::load(m_file));
+
+    for (auto fen : FENS)
+    {
+        ASSERT_TRUE(NNUE::setKernel(NNUE::SCALAR));
+        Board scalar_board(fen);
+        int expected = NNUE::evaluate(scalar_board);
+
+        for (auto kernel : {NNUE::SSE41, NNUE::AVX2})
+        {
+            if (!NNUE::setKernel(kernel))
+                continue;
+
+            Board board(fen);
+            EXPECT_EQ(NNUE::evaluate(board), expected) << fen << " " << NNUE::kernelName();
+        }
+    }
+}
+
+TEST_F(NNUETest, fallbackToHandcraftedEval)
+{
+    for (auto fen : FENS)
+    {
+        Board board(fen);
+        int handcrafted = Eval::evaluate(board);
+
+        ASSERT_TRUE(NNUE::load(m_file));
+        EXPECT_EQ(Eval::evaluate(board), NNUE::evaluate(board)) << fen;
+
+        NNUE::setEnabled(false);
+        EXPECT_EQ(Eval::evaluate(board), handcrafted) << fen;
+
+        NNUE::setEnabled(true);
+        NNUE::unload();
+        EXPECT_EQ(Eval::evaluate(board), handcrafted) << fen;
+    }
+}
+
+} // namespace
@@ -53,6 +53,35 @@ namespace
             chess::init();
             perft = bench::Perft();
         }
+
+        // Perft with the pseudo-legal generator, the moves are validated by `isLegalAfter`,
+        // evasions are used in check if `evasions` is set
+        static uint64_t pseudoPerft(chess::Board& board, int depth, bool evasions)
+        {
+            board.updateChecks();
+            chess::MoveList moves = board.inCheck() && evasions
+                ? board.generatePseudoLegalMoves<chess::EVASIONS>()
+                : board.generatePseudoLegalMoves();
+
+            uint64_t nodes = 0;
+            const chess::Position position = board.position();
+            for (auto m : moves)
+            {
+                if (!board.isLegalAfter(chess::Move(m)))
+                    continue;
+
+                if (depth == 1)
+                {
+                    nodes++;
+                    continue;
+                }
+
+                board.makeMove(chess::Move(m));
+                nodes += pseudoPerft(board, depth - 1, evasions);
+                board.restore(position);
+            }
+            return nodes;
+        }
     };
 
     
@@ -69,4 +98,48 @@ namespace
         }
     }
 
+
+    TEST_F(PerftTest, ParallelHashedPerft)
+    {
+        bench::Perft parallel(false, 4, 16);
+        bench::Perft plain(false, 1, 0);
+
+        for (auto& t : data)
+        {
+            ASSERT_EQ(parallel.run(t.depth, t.fen), t.nodes) << " for given FEN = " << t.fen;
+
+            // Same table, positions are already hashed
+            ASSERT_EQ(parallel.run(t.depth, t.fen), t.nodes) << " for given FEN = " << t.fen;
+
+            if (t.nodes < 1000000)
+                ASSERT_EQ(plain.run(t.depth, t.fen), t.nodes) << " for given FEN = " << t.fen;
+        }
+    }
+
+    TEST_F(PerftTest, PseudoLegalPerft)
+    {
+        for (auto& t : data)
+        {
+            if (t.nodes > 1500000)
+                continue;
+
+            chess::Board board(t.fen);
+            ASSERT_EQ(pseudoPerft(board, t.depth, true), t.nodes) << " for given FEN = " << t.fen;
+            ASSERT_EQ(pseudoPerft(board, std::min(t.depth, 4), false), perft.run(std::min(t.depth, 4), t.fen)) 
+                << " for given FEN = " << t.fen;
+        }
+    }
+
+    TEST_F(PerftTest, PerftSuite)
+    {
+        auto entries = bench::Perft::parseSuite(bench::perft_suite, 3);
+        ASSERT_EQ(entries.size(), 7UL);
+        EXPECT_EQ(entries[0].fen, chess::Board::START_FEN);
+        EXPECT_EQ(entries[0].depth, 3);
+        EXPECT_EQ(entries[0].nodes, 8902UL);
+
+        bench::Perft suite(false, 2);
+        EXPECT_TRUE(suite.suite(4));
+    }
+
 }
\ No newline at end of file
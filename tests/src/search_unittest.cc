@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+#include "includes.h"
+
+namespace
+{
+
+using namespace chess;
+
+class SearchTest: public ::testing::Test
+{
+protected:
+    Engine engine;
+
+    void SetUp() override
+    {
+        chess::init();
+        glogger.setPrint(false);
+    }
+
+    void TearDown() override
+    {
+        glogger.setPrint(true);
+    }
+
+    // Run a fixed depth search on given position
+    Result search(std::string fen, int depth)
+    {
+        SearchOptions options;
+        options["depth"] = depth;
+
+        engine.setPosition(fen);
+        auto& result = engine.go(options);
+        engine.join();
+        return result.get();
+    }
+};
+
+
+TEST_F(SearchTest, lazySmpBestMoveIsLegal)
+{
+    constexpr const char* FENS[] = {
+        Board::START_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    engine.setThreads(4);
+    ASSERT_EQ(engine.threads(), 4UL);
+
+    for (const auto& fen : FENS)
+    {
+        Result result = search(fen, 5);
+        EXPECT_GE(result.depth, 5) << "FEN: " << fen;
+        EXPECT_GT(result.nodes, 0UL) << "FEN: " << fen;
+        EXPECT_TRUE(engine.board().isLegal(result.bestmove)) << "FEN: " << fen;
+    }
+}
+
+TEST_F(SearchTest, lazySmpFindsMate)
+{
+    engine.setThreads(2);
+    Result result = search("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1", 5);
+    EXPECT_EQ(result.bestmove.uci(), "d1d8");
+    EXPECT_EQ(result.score.type, Score::mate);
+}
+
+TEST_F(SearchTest, findsStalemateDefence)
+{
+    // White is lost, unless the rook is sacrificed for a stalemate (or perpetual check)
+    Result result = search("7k/8/8/8/8/8/5q2/6RK w - - 0 1", 8);
+    EXPECT_EQ(result.score.type, Score::cp);
+    EXPECT_EQ(result.score.value, 0);
+    EXPECT_TRUE(result.bestmove.uci() == "g1g7" || result.bestmove.uci() == "g1g8") << result.bestmove.uci();
+}
+
+TEST_F(SearchTest, stopsAtTheLimits)
+{
+    engine.setPosition("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+    // Node limit is checked exactly, the search may only finish the current quiescence search
+    SearchOptions options;
+    options["nodes"] = 30000;
+    auto& result = engine.go(options);
+    engine.join();
+    EXPECT_GT(result.get().nodes, 30000UL);
+    EXPECT_LT(result.get().nodes, 31000UL);
+
+    // Time limit, the clock is polled often enough to stop in time
+    SearchOptions timed;
+    timed["movetime"] = 100;
+    auto  start    = TimeMan::now();
+    auto& result_t = engine.go(timed);
+    engine.join();
+    EXPECT_LT(TimeMan::to_ms(start, TimeMan::now()), 1000UL);
+    EXPECT_GT(result_t.get().depth, 0);
+}
+
+TEST_F(SearchTest, allocatesTimeFromClock)
+{
+    TimeLimits limits;
+    limits.time[1] = 60000;
+    limits.inc[1]  = 1000;
+
+    TimeMan sudden_death(limits);
+    sudden_death.init(true);
+    EXPECT_GT(sudden_death.optimum(), 1000UL);
+    EXPECT_LT(sudden_death.optimum(), sudden_death.maximum());
+    EXPECT_LT(sudden_death.maximum(), 60000UL / 4);
+
+    // Black has no clock set, so nothing is managed
+    TimeMan black(limits);
+    black.init(false);
+    EXPECT_FALSE(black.stop_iterating());
+
+    // Last move before the time control may use the whole clock
+    limits.movestogo = 1;
+    TimeMan last_move(limits);
+    last_move.init(true);
+    EXPECT_EQ(last_move.maximum(), 60000UL - TimeMan::MOVE_OVERHEAD);
+
+    // Search with a short clock stops well before it runs out
+    SearchOptions options;
+    options["wtime"] = 1000;
+    options["btime"] = 1000;
+    engine.setPosition(Board::START_FEN);
+    auto  start  = TimeMan::now();
+    auto& result = engine.go(options);
+    engine.join();
+    EXPECT_LT(TimeMan::to_ms(start, TimeMan::now()), 500UL);
+    EXPECT_GT(result.get().depth, 0);
+}
+
+TEST_F(SearchTest, ponderTimeIsNotCountedInIterations)
+{
+    TimeLimits limits;
+    limits.time[1] = 3000;
+
+    // Long iteration while pondering, then the ponderhit
+    TimeMan time_man(limits);
+    time_man.init(true);
+    time_man.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    time_man.ponderhit();
+
+    // The next iteration is predicted from our clock only
+    time_man.iteration(false, 0);
+    EXPECT_LT(time_man.predict(), time_man.maximum());
+    EXPECT_FALSE(time_man.stop_iterating());
+}
+
+TEST_F(SearchTest, ponderhitContinuesTheSearch)
+{
+    SearchOptions options;
+    options["movetime"] = 50;
+    options["ponder"]   = true;
+
+    // The time limits don't apply while pondering
+    engine.setPosition(Board::START_FEN);
+    auto& result = engine.go(options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_TRUE(engine.m_main_thread.is_thinking());
+
+    // After the ponderhit the search stops by the time limit, keeping the iterations done so far
+    auto start = TimeMan::now();
+    engine.ponderhit();
+    engine.join();
+    EXPECT_LT(TimeMan::to_ms(start, TimeMan::now()), 1000UL);
+    EXPECT_GT(result.get().depth, 3);
+    EXPECT_GE(result.get().pv.size(), 2UL);
+}
+
+TEST_F(SearchTest, resizingHashStopsTheSearch)
+{
+    SearchOptions options;
+    options["infinite"] = true;
+
+    // The table is reallocated in place, so the running search must be stopped first
+    engine.setThreads(2);
+    engine.setPosition(Board::START_FEN);
+    auto& result = engine.go(options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Same size, the table is kept and the search goes on
+    engine.setHashSize(engine.m_search_cache.getTT().sizeMB());
+    EXPECT_TRUE(engine.m_main_thread.is_thinking());
+
+    engine.setHashSize(4);
+    EXPECT_FALSE(engine.m_main_thread.is_thinking());
+    EXPECT_EQ(engine.m_search_cache.getTT().sizeMB(), 4UL);
+    EXPECT_TRUE(engine.board().isLegal(result.get().bestmove));
+}
+
+TEST_F(SearchTest, multiPVReturnsDistinctLines)
+{
+    engine.setMultiPV(3);
+    Result result = search("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5);
+
+    ASSERT_EQ(result.lines.size(), 3UL);
+    EXPECT_EQ(result.lines[0].bestmove, result.bestmove);
+    for (size_t i = 0; i < result.lines.size(); i++)
+    {
+        EXPECT_TRUE(engine.board().isLegal(result.lines[i].bestmove));
+        EXPECT_EQ(result.lines[i].pv[0], result.lines[i].bestmove);
+        for (size_t j = 0; j < i; j++)
+        {
+            EXPECT_NE(result.lines[i].bestmove, result.lines[j].bestmove);
+            EXPECT_GE(result.lines[j].score.value, result.lines[i].score.value);
+        }
+    }
+
+    // Not more lines than the legal moves
+    engine.setMultiPV(4);
+    result = search("7k/8/8/8/8/8/1p6/K7 w - - 0 1", 4);
+    EXPECT_EQ(result.lines.size(), 3UL);
+}
+
+TEST_F(SearchTest, principalVariationIsComplete)
+{
+    const std::string fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+
+    // The second search starts with the table filled by the first one
+    for (int run = 0; run < 2; run++)
+    {
+        Result result = search(fen, 6);
+        ASSERT_GE(result.pv.size(), 6UL) << "run " << run;
+        EXPECT_EQ(result.pv[0], result.bestmove) << "run " << run;
+
+        Board board(fen);
+        for (auto m : result.pv)
+        {
+            ASSERT_TRUE(board.isLegal(Move(m))) << "run " << run << " move " << Move(m).uci();
+            board.makeMove(Move(m));
+        }
+    }
+}
+
+TEST_F(SearchTest, benchIsDeterministic)
+{
+    bench::Bench bench(false);
+    auto first  = bench.run(3);
+    auto second = bench.run(3);
+
+    EXPECT_EQ(bench::bench_positions.size(), 50UL);
+    EXPECT_GT(first.nodes, 0UL);
+    EXPECT_EQ(first.nodes, second.nodes);
+    EXPECT_EQ(first.signature, second.signature);
+}
+
+} // namespace
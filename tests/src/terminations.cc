@@ -82,4 +82,33 @@ TEST_F(TerminationTest, threefoldRepetition)
     }
 }
 
+TEST_F(TerminationTest, searchRepetition)
+{
+    // The position repeats once, a draw only if it happened inside the search tree
+    position("8/8/8/r7/8/7K/2k5/8 w - - 0 1 moves h3g3 a5a4 g3h3 a4a5");
+    EXPECT_FALSE(board.isRepetition(0));
+    EXPECT_FALSE(board.isRepetition(4));
+    EXPECT_TRUE(board.isRepetition(5));
+
+    // Repeated twice before the root
+    position("8/8/8/r7/8/7K/2k5/8 w - - 0 1 moves h3g3 a5a4 g3h3 a4a5 h3g3 a5a4 g3h3 a4a5");
+    EXPECT_TRUE(board.isRepetition(0));
+}
+
+TEST_F(TerminationTest, upcomingRepetition)
+{
+    // Black can play a4a5, repeating the start position
+    position("8/8/8/r7/8/7K/2k5/8 w - - 0 1 moves h3g3 a5a4 g3h3");
+    EXPECT_FALSE(board.isRepetition(4));
+    EXPECT_TRUE(board.hasUpcomingRepetition(4));
+    EXPECT_FALSE(board.hasUpcomingRepetition(3));
+
+    // Rook can go back from a3 to a5 in one move, unless the path is blocked
+    position("8/8/8/r7/8/8/2k5/7K w - - 0 1 moves h1g1 a5b5 g1h1 b5b3 h1g1 b3a3");
+    EXPECT_TRUE(board.hasUpcomingRepetition(8));
+
+    position("8/8/8/r7/N7/8/2k5/7K w - - 0 1 moves h1g1 a5b5 g1h1 b5b3 h1g1 b3a3");
+    EXPECT_FALSE(board.hasUpcomingRepetition(8));
+}
+
 } // namespace
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include "includes.h"
+
+namespace
+{
+
+using namespace chess;
+
+class TranspositionTableTest: public ::testing::Test
+{
+protected:
+    TranspositionTable tt{1};
+
+    // Hash pointing to the same cluster as `hash`, but with different key
+    static uint64_t sameCluster(uint64_t hash, int n)
+    {
+        return (hash & ~0xffffULL) | uint64_t(n + 1);
+    }
+};
+
+
+TEST_F(TranspositionTableTest, resize)
+{
+    const uint64_t hash = 0x123456789abcdef0ULL;
+    TEntry entry;
+
+    tt.resize(3);
+    EXPECT_EQ(tt.sizeMB(), 3UL);
+    EXPECT_EQ(tt.bytes(), 3UL << 20);
+    EXPECT_EQ(tt.size(), (3UL << 20) / sizeof(TCluster) * TCluster::N_ENTRIES);
+
+    // Same size, the table is kept
+    tt.store(hash, 7, 10, TEntry::EXACT, Move::nullMove);
+    tt.resize(3);
+    EXPECT_TRUE(tt.probe(hash, entry));
+
+    // New table is empty
+    tt.resize(5);
+    EXPECT_FALSE(tt.probe(hash, entry));
+    tt.store(hash, 7, 10, TEntry::EXACT, Move::nullMove);
+    EXPECT_TRUE(tt.probe(hash, entry));
+    
+    // Allocation failure keeps the old table
+    EXPECT_FALSE(tt.resize(size_t(1) << 40));
+    EXPECT_EQ(tt.sizeMB(), 5UL);
+    EXPECT_TRUE(tt.probe(hash, entry));
+
+    tt.clear(4);
+    EXPECT_FALSE(tt.probe(hash, entry));
+}
+
+TEST_F(TranspositionTableTest, storeAndProbe)
+{
+    const uint64_t hash = 0x123456789abcdef0ULL;
+    TEntry entry;
+
+    EXPECT_FALSE(tt.probe(hash, entry));
+
+    tt.store(hash, 7, -150, TEntry::LOWERBOUND, Move(12, 28, Move::FLAG_DOUBLE_PAWN), 42);
+    ASSERT_TRUE(tt.probe(hash, entry));
+    EXPECT_EQ(entry.depth, 7);
+    EXPECT_EQ(entry.score, -150);
+    EXPECT_EQ(entry.eval, 42);
+    EXPECT_EQ(entry.nodeType(), TEntry::LOWERBOUND);
+    EXPECT_EQ(entry.bestMove, Move(12, 28, Move::FLAG_DOUBLE_PAWN));
+
+    // Same cluster, different key
+    EXPECT_FALSE(tt.probe(sameCluster(hash, 1), entry));
+
+    tt.clear();
+    EXPECT_FALSE(tt.probe(hash, entry));
+}
+
+TEST_F(TranspositionTableTest, mateScoresFit)
+{
+    const uint64_t hash = 0xfedcba9876543210ULL;
+    TEntry entry;
+
+    tt.store(hash, 3, MATE + 5, TEntry::EXACT, Move::nullMove);
+    ASSERT_TRUE(tt.probe(hash, entry));
+    EXPECT_EQ(entry.score, MATE + 5);
+}
+
+TEST_F(TranspositionTableTest, replacementKeepsDeepEntries)
+{
+    const uint64_t hash = 0x0badc0ffee000000ULL;
+    TEntry entry;
+
+    // Fill the cluster, the shallowest entry should be replaced first
+    for (int i = 0; i < TCluster::N_ENTRIES; i++)
+        tt.store(sameCluster(hash, i), 10 + i, i, TEntry::EXACT, Move::nullMove);
+    
+    tt.store(sameCluster(hash, TCluster::N_ENTRIES), 1, 0, TEntry::EXACT, Move::nullMove);
+    EXPECT_FALSE(tt.probe(sameCluster(hash, 0), entry));
+    EXPECT_TRUE(tt.probe(sameCluster(hash, TCluster::N_ENTRIES), entry));
+
+    for (int i = 1; i < TCluster::N_ENTRIES; i++)
+        EXPECT_TRUE(tt.probe(sameCluster(hash, i), entry));
+
+    // Entries from the old searches are replaced before the deep ones
+    tt.new_search();
+    tt.store(sameCluster(hash, 100), 2, 0, TEntry::EXACT, Move::nullMove);
+    EXPECT_TRUE(tt.probe(sameCluster(hash, 100), entry));
+}
+
+TEST_F(TranspositionTableTest, tornEntryIsRejected)
+{
+    TEntry entry;
+    entry.score    = 100;
+    entry.depth    = 5;
+    entry.genbound = TEntry::EXACT;
+    entry.key      = 0xabcd ^ entry.data_key();
+    EXPECT_EQ(entry.key ^ entry.data_key(), 0xabcd);
+
+    // Simulate a partially written entry, data doesn't match the key anymore
+    entry.score    = -2000;
+    EXPECT_NE(entry.key ^ entry.data_key(), 0xabcd);
+}
+
+TEST(PawnTable, cachedEvalMatchesUncached)
+{
+    chess::init();
+
+    // Same pawn structure (pawn key) with both sides to move
+    constexpr const char* FENS[] = {
+        "4k3/pp3ppp/2p5/3p4/3P4/2P1P3/PP3PPP/4K3 w - - 0 1",
+        "4k3/pp3ppp/2p5/3p4/3P4/2P1P3/PP3PPP/4K3 b - - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    };
+
+    SearchCache cache, other;
+    for (auto fen : FENS)
+    {
+        Board board(fen);
+        int uncached = Eval::evaluate(board);
+        EXPECT_EQ(Eval::evaluate(board, &cache.getPT()), uncached) << fen;
+        EXPECT_TRUE(cache.getPT().contains(board.getPawnHash())) << fen;
+        EXPECT_EQ(Eval::evaluate(board, &cache.getPT()), uncached) << fen;
+    }
+
+    // Tables are owned by the caches (threads)
+    Board board(FENS[0]);
+    EXPECT_FALSE(other.getPT().contains(board.getPawnHash()));
+
+    cache.resizePawnTable(SearchCache::DEFAULT_PAWN_HASH_SIZE);
+    EXPECT_TRUE(cache.getPT().contains(board.getPawnHash()));
+    cache.resizePawnTable(2);
+    EXPECT_FALSE(cache.getPT().contains(board.getPawnHash()));
+    EXPECT_EQ(cache.getPT().getTable().size(), (2UL << 20) / sizeof(PawnEntry));
+}
+
+TEST_F(TranspositionTableTest, sharedBetweenCaches)
+{
+    const uint64_t hash = 0x123456789abcdef0ULL;
+    TEntry entry;
+
+    // Helper cache uses the table of the main one, the pawn table is its own
+    SearchCache main, helper(main, 2);
+    EXPECT_EQ(&helper.getTT(), &main.getTT());
+    EXPECT_NE(&helper.getPT(), &main.getPT());
+    EXPECT_EQ(helper.getPT().getTable().size(), (2UL << 20) / sizeof(PawnEntry));
+
+    main.getTT().store(hash, 7, 10, TEntry::EXACT, Move::nullMove);
+    EXPECT_TRUE(helper.getTT().probe(hash, entry));
+
+    // The resized table stays shared
+    main.getTT().resize(3);
+    EXPECT_EQ(helper.getTT().sizeMB(), 3UL);
+}
+
+} // namespace